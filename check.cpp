@@ -0,0 +1,338 @@
+// regression checks of the placer library, run by `make check` from the repository root.
+// Every check prints one line and the program exits with status 1 when any of them fails.
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include "placer.h"
+
+using namespace std;
+
+int failures = 0;
+
+void expect(bool passed, const string &check) {
+    cout << (passed ? "PASS " : "FAIL ") << check << endl;
+    if (!passed) {
+        failures++;
+    }
+}
+
+bool sameBox(const boundingBox &a, const boundingBox &b) {
+    return a.minX == b.minX && a.maxX == b.maxX && a.minY == b.minY && a.maxY == b.maxY &&
+           a.minXCount == b.minXCount && a.maxXCount == b.maxXCount &&
+           a.minYCount == b.minYCount && a.maxYCount == b.maxYCount && a.HPWL == b.HPWL;
+}
+
+// the incrementally kept state of a placement against a recomputation from the cell positions:
+// every net box with its edge counts, the total wire length, the grid and the free-site list
+bool matchesFullRecompute(const placement &p) {
+    const netList &design = *p.design;
+    placement recomputed = p;
+    computeHPWLofAllNets(recomputed);
+    if (recomputed.totalWireLength != p.totalWireLength) {
+        return false;
+    }
+    for (int i = 0; i < design.numOfNets; i++) {
+        if (!sameBox(p.nets[i], recomputed.nets[i])) {
+            return false;
+        }
+    }
+    for (int c = 0; c < design.numOfCells; c++) {
+        if (p.grid.at(p.cellY[c], p.cellX[c]) != c) {
+            return false;
+        }
+    }
+    int emptySites = 0;
+    for (int site = 0; site < design.numOfRows * design.numOfColumns; site++) {
+        if (p.grid.atSite(site) == -1) {
+            emptySites++;
+            if (p.grid.freeSlot[site] == -1 || p.grid.freeSites[p.grid.freeSlot[site]] != site) {
+                return false;
+            }
+        }
+    }
+    return emptySites == p.grid.freeSites.size();
+}
+
+bool placeRandomly(const netList &design, placement &p, uint64_t seed) {
+    resetPlacement(p, design);
+    if (!placeInitiallyRandom(p, seed)) {
+        return false;
+    }
+    computeHPWLofAllNets(p);
+    return true;
+}
+
+void checkIncrementalHPWL(const netList &design, const string &name) {
+    placement p;
+    expect(placeRandomly(design, p, 11), name + ": random placement");
+    int steps = simulateAnnealing(p, legacyTemperatureRange(design, p.totalWireLength), 0.8, GEOMETRIC_COOLING, 11);
+    expect(steps > 0 && matchesFullRecompute(p), name + ": incremental HPWL matches a full recompute after annealing");
+    placement adaptive;
+    placeRandomly(design, adaptive, 12);
+    simulateAnnealing(adaptive, calibrateTemperatureRange(adaptive, 4000, 12), 0.95, ADAPTIVE_COOLING, 12);
+    expect(matchesFullRecompute(adaptive), name + ": incremental HPWL matches a full recompute after an adaptive anneal");
+    // stamps left behind 2^32 moves ago must not match the moves after the wrap, so every move
+    // around it is committed regardless of its cost
+    placement wrapped;
+    placeRandomly(design, wrapped, 13);
+    wrapped.scratch.moveStamp = UINT32_MAX;
+    fill(wrapped.scratch.netMoveStamp.begin(), wrapped.scratch.netMoveStamp.end(), 1);
+    fill(wrapped.scratch.netCell2Stamp.begin(), wrapped.scratch.netCell2Stamp.end(), 1);
+    annealRng rng(13);
+    for (int i = 0; i < 100; i++) {
+        swapMove candidate = proposeMove(wrapped, rng, max(design.numOfRows, design.numOfColumns));
+        evaluateMove(wrapped, candidate);
+        commitMove(wrapped, candidate);
+    }
+    expect(matchesFullRecompute(wrapped), name + ": incremental HPWL matches a full recompute across a move stamp wrap");
+}
+
+// the speculative tail commits boxes computed on worker threads, some of them re-evaluated after a
+// conflict, so its state has to match a recompute just like a sequential anneal's
+void checkSpeculativeAnneal(const netList &design, const string &name) {
+    placement p;
+    placeRandomly(design, p, 21);
+    speculativeAnnealer speculation(3);
+    ostringstream steps;
+    traceRecorder trace(&steps, 21, 100);
+    simulateAnnealing(p, legacyTemperatureRange(design, p.totalWireLength), 0.8, GEOMETRIC_COOLING, 21, &speculation, &trace);
+    expect(speculation.reevaluatedMoves > 0, name + ": speculative anneal re-evaluates conflicting moves");
+    expect(matchesFullRecompute(p), name + ": incremental HPWL matches a full recompute after a speculative anneal");
+    expect(trace.reservoir.size() == 100 && trace.movesSeen % (10 * design.numOfCells) == 0,
+           name + ": speculative anneal records every move in the trace");
+    // the same annealer on a taller grid with the same cells and nets has to size its site stamps anew
+    netList taller = design;
+    taller.numOfRows *= 2;
+    placement tall;
+    placeRandomly(taller, tall, 22);
+    simulateAnnealing(tall, legacyTemperatureRange(taller, tall.totalWireLength), 0.8, GEOMETRIC_COOLING, 22, &speculation);
+    expect(speculation.siteStamp.size() == (size_t)taller.numOfRows * taller.numOfColumns && matchesFullRecompute(tall),
+           name + ": a reused speculative annealer matches a full recompute on a larger grid");
+}
+
+// the region engine moves cells on disjoint stripes of the grid; region counts that do not divide
+// the rows or columns leave a short last stripe, whose moves must stay on the grid
+void checkRegionAnneal(const netList &design, const string &name) {
+    for (int regions : {4, 7}) {
+        placement p;
+        placeRandomly(design, p, 31);
+        int steps = simulateAnnealingRegions(p, calibrateTemperatureRange(p, 4000, 31), GEOMETRIC_COOLING, regions, 31);
+        expect(steps > 0 && matchesFullRecompute(p), name + ": placement matches a full recompute after annealing on " + to_string(regions) + " regions");
+    }
+}
+
+// hogwild boxes may go stale within a step, but every step ends with a recompute and the sites
+// are only changed under claims, so the placement it leaves must be consistent
+void checkHogwildAnneal(const netList &design, const string &name) {
+    placement p;
+    placeRandomly(design, p, 41);
+    int steps = simulateAnnealingHogwild(p, calibrateTemperatureRange(p, 4000, 41), GEOMETRIC_COOLING, 4, 41);
+    expect(steps > 0 && matchesFullRecompute(p), name + ": placement matches a full recompute after a hogwild anneal");
+}
+
+// the best placement of a replica exchange run is copied out of a rung, so it has to be consistent
+// and match the reported wire length, and a run is reproducible from its seed
+void checkParallelTempering(const netList &design, const string &name) {
+    placement calibration;
+    placeRandomly(design, calibration, 51);
+    temperatureRange range = calibrateTemperatureRange(calibration, 4000, 51);
+    placement best, again;
+    temperingResult result = runParallelTempering(design, best, 4, 5, range, 51);
+    expect(result.placed && result.finalWireLength == best.totalWireLength && matchesFullRecompute(best),
+           name + ": best placement of parallel tempering matches a full recompute");
+    temperingResult repeated = runParallelTempering(design, again, 4, 5, range, 51);
+    expect(repeated.finalWireLength == result.finalWireLength && repeated.acceptedExchanges == result.acceptedExchanges &&
+           again.cellX == best.cellX && again.cellY == best.cellY,
+           name + ": parallel tempering is reproducible from its seed");
+}
+
+bool sameConnectivity(const netList &a, const netList &b) {
+    return a.numOfCells == b.numOfCells && a.numOfNets == b.numOfNets &&
+           a.numOfRows == b.numOfRows && a.numOfColumns == b.numOfColumns &&
+           a.netPinStart == b.netPinStart && a.netPins == b.netPins &&
+           a.cellNetStart == b.cellNetStart && a.cellNets == b.cellNets;
+}
+
+// scratch file of a check, removed again by the check
+const string scratchFileName = "check_placer.tmp";
+
+void writeScratchFile(const string &contents) {
+    ofstream file(scratchFileName, ios::binary);
+    file << contents;
+}
+
+// the chunked parser has to build the CSR arrays a single thread builds, whatever the chunk
+// boundaries, and report a bad line whichever chunk it lands in
+void checkParseThreads(const netList &design, const string &name) {
+    bool same = true;
+    for (int threads : {2, 3, 4, 7, 16}) {
+        netList parsed;
+        same = parseNetListFile(parsed, "TestCases/" + name + ".txt", threads, false) && sameConnectivity(parsed, design) && same;
+    }
+    expect(same, name + ": multi-threaded parses give the single-threaded CSR arrays");
+}
+
+void checkParseEdgeCases() {
+    // blank padding, carriage returns, repeated pins and no newline at the end
+    writeScratchFile("4 3 2 3\r\n2 0 1 \r\n  3 1 2 1\t\n4 3 0 1 2");
+    netList single, parsed;
+    bool parsedSingle = parseNetListFile(single, scratchFileName, 1, false);
+    bool same = parsedSingle;
+    for (int threads : {2, 3, 8}) {
+        same = parseNetListFile(parsed, scratchFileName, threads, false) && sameConnectivity(parsed, single) && same;
+    }
+    expect(parsedSingle && single.netPins == vector<int>({0, 1, 1, 2, 3, 0, 1, 2}), "parse: duplicate pins are dropped");
+    expect(same, "parse: awkward layout gives the same CSR arrays on every thread count");
+
+    writeScratchFile("3 4 2 2\n2 0 1\n2 1 2\n2 0 2\n2 0 7\n");
+    bool rejected = true;
+    for (int threads : {1, 2, 4}) {
+        rejected = !parseNetListFile(parsed, scratchFileName, threads, false) && rejected;
+    }
+    expect(rejected, "parse: an unknown cell on the last line is rejected on every thread count");
+    remove(scratchFileName.c_str());
+}
+
+// cellNets of the given pins, built like the parser does so the binary checks can write files
+// whose only fault is the one they test
+void transposePins(netList &design) {
+    design.cellNetStart.assign(design.numOfCells + 1, 0);
+    for (int i = 0; i < design.netPins.size(); i++) {
+        design.cellNetStart[design.netPins[i] + 1]++;
+    }
+    for (int c = 0; c < design.numOfCells; c++) {
+        design.cellNetStart[c + 1] += design.cellNetStart[c];
+    }
+    vector<int> nextSlot(design.cellNetStart.begin(), design.cellNetStart.end() - 1);
+    design.cellNets.resize(design.netPins.size());
+    for (int n = 0; n < design.numOfNets; n++) {
+        for (int i = design.netPinStart[n]; i < design.netPinStart[n + 1]; i++) {
+            design.cellNets[nextSlot[design.netPins[i]]++] = n;
+        }
+    }
+}
+
+bool loadsFromBinary(const netList &written, netList &loaded) {
+    return writeBinaryNetList(written, scratchFileName) && parseNetListFile(loaded, scratchFileName, 0, false);
+}
+
+// a binary netlist loads back to the arrays it was written from, and the loader rejects files
+// that break what the incremental boxes rely on
+void checkBinaryNetList(const netList &design, const string &name) {
+    netList loaded;
+    expect(loadsFromBinary(design, loaded) && sameConnectivity(loaded, design), name + ": binary netlist loads back unchanged");
+
+    int net = 0;
+    while (design.netPinStart[net + 1] - design.netPinStart[net] < 2) {
+        net++;
+    }
+    netList repeatedPin = design;
+    repeatedPin.netPins[design.netPinStart[net] + 1] = repeatedPin.netPins[design.netPinStart[net]];
+    transposePins(repeatedPin);
+    expect(!loadsFromBinary(repeatedPin, loaded), name + ": binary netlist with a repeated pin is rejected");
+
+    netList reordered = design;
+    int cell = design.netPins[design.netPinStart[net]];
+    int first = reordered.cellNetStart[cell], last = reordered.cellNetStart[cell + 1] - 1;
+    if (first == last) {
+        reordered.cellNets[first] = (reordered.cellNets[first] + 1) % design.numOfNets;
+    } else {
+        swap(reordered.cellNets[first], reordered.cellNets[last]);
+    }
+    expect(!loadsFromBinary(reordered, loaded), name + ": binary netlist whose cellNets are not the transpose of netPins is rejected");
+
+    writeBinaryNetList(design, scratchFileName);
+    string contents;
+    {
+        ifstream file(scratchFileName, ios::binary);
+        contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+    writeScratchFile(contents.substr(0, contents.size() - sizeof(int)));
+    expect(!parseNetListFile(loaded, scratchFileName, 0, false), name + ": truncated binary netlist is rejected");
+    remove(scratchFileName.c_str());
+}
+
+// random nets of every degree around the vector widths and the AVX-512 cutoff on a grid small
+// enough that many pins share a row or column, so the edge counts of every lane merge are tested
+void checkHPWLKernels() {
+    netList design;
+    design.numOfCells = 4000;
+    design.numOfRows = design.numOfColumns = 64;
+    annealRng rng(31);
+    vector<int> degrees = {0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 127, 128, 129, 300, 1000};
+    for (int i = 0; i < 500; i++) {
+        degrees.push_back(randomBetween(rng, 0, 400));
+    }
+    // enough 2-pin nets for some to have both pins in one row or column, see twoPinNetBox()
+    degrees.insert(degrees.end(), 1000, 2);
+    vector<int> cells(design.numOfCells);
+    for (int c = 0; c < design.numOfCells; c++) {
+        cells[c] = c;
+    }
+    design.netPinStart.assign(1, 0);
+    for (int degree : degrees) {
+        shuffle(cells.begin(), cells.end(), rng);
+        design.netPins.insert(design.netPins.end(), cells.begin(), cells.begin() + degree);
+        design.netPinStart.push_back(design.netPins.size());
+    }
+    design.numOfNets = degrees.size();
+    transposePins(design);
+
+    vector<int> allNets(design.numOfNets);
+    for (int n = 0; n < design.numOfNets; n++) {
+        allNets[n] = n;
+    }
+    placement p;
+    placeRandomly(design, p, 31);
+    int expectedTotal = computeHPWLofNets(p, allNets, SCALAR_HPWL);
+    vector<boundingBox> expected = p.nets;
+    for (hpwlKernel kernel : {AVX2_HPWL, AVX512_HPWL}) {
+        if (!hpwlKernelSupported(kernel)) {
+            cout << "SKIP " << hpwlKernelName(kernel) << " kernel, not supported by this processor" << endl;
+            continue;
+        }
+        p.nets.assign(design.numOfNets, boundingBox());
+        bool same = computeHPWLofNets(p, allNets, kernel) == expectedTotal;
+        for (int n = 0; n < design.numOfNets; n++) {
+            same = same && sameBox(p.nets[n], expected[n]);
+        }
+        expect(same, string("kernels: ") + hpwlKernelName(kernel) + " boxes match the scalar ones on random nets");
+    }
+    p.nets.assign(design.numOfNets, boundingBox());
+    computeHPWLofAllNets(p);
+    bool same = p.totalWireLength == expectedTotal;
+    for (int n = 0; n < design.numOfNets; n++) {
+        same = same && sameBox(p.nets[n], expected[n]);
+    }
+    expect(same, string("kernels: computeHPWLofAllNets with the ") + hpwlKernelName(detectHPWLKernel()) + " kernel and the 2-pin path matches the scalar boxes");
+}
+
+int main() {
+    vector<string> netListNames = {"d1", "d2", "t1", "t3"};
+    vector<netList> designs(netListNames.size());
+    for (int i = 0; i < netListNames.size(); i++) {
+        if (!parseNetListFile(designs[i], "TestCases/" + netListNames[i] + ".txt", 0, false)) {
+            cout << "FAIL cannot read TestCases/" << netListNames[i] << ".txt, run from the repository root" << endl;
+            return 1;
+        }
+    }
+    for (int i = 0; i < designs.size(); i++) {
+        checkIncrementalHPWL(designs[i], netListNames[i]);
+        checkSpeculativeAnneal(designs[i], netListNames[i]);
+        checkRegionAnneal(designs[i], netListNames[i]);
+        checkHogwildAnneal(designs[i], netListNames[i]);
+        checkParallelTempering(designs[i], netListNames[i]);
+        checkParseThreads(designs[i], netListNames[i]);
+        checkBinaryNetList(designs[i], netListNames[i]);
+    }
+    checkParseEdgeCases();
+    checkHPWLKernels();
+
+    cout << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -4,15 +4,15 @@
 #include <vector>
 #include <sstream>
 #include <cctype>
-#include <random>
-#include <climits>
 #include <chrono>
 #include <iomanip>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <climits>
 #include "CImg.h"
-
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <unistd.h>
+#include "placer.h"
 
 
 using namespace cimg_library;
@@ -22,35 +22,7 @@ using namespace std::chrono;
 
 
 
-struct cell{
-    int id;
-    int x; // column number
-    int y; // row number
-    vector<int> nets; //list of nets it's conencted to
-    cell() {}
-    cell(int id) {
-        this->id = id;
-        x = y = -1;
-    }
-};
-
-vector<cell> cells;
-
-//represents a connection between cells
-struct net{
-    int id;
-    int minX, minY, maxX, maxY;
-    int minXCell, minYCell, maxXCell, maxYCell;
-    int HPWL;
-    vector<int> cells;
-    net() {}
-    net(int id) {
-        this->id = id;
-        minX = minY = maxX = maxY = HPWL = 0;
-    }
-};
-
-void saveGridImage(const vector<vector<int>>& grid, int iteration, int numOfRows, int numOfColumns, int scaleFactor) {
+void saveGridImage(const placementGrid& grid, int iteration, int numOfRows, int numOfColumns, int scaleFactor) {
     int scaledWidth = numOfColumns * scaleFactor;
     int scaledHeight = numOfRows * scaleFactor;
 
@@ -60,7 +32,7 @@ void saveGridImage(const vector<vector<int>>& grid, int iteration, int numOfRows
         for (int x = 0; x < numOfColumns; ++x) {
             unsigned char color[3] = {255, 255, 255}; // Default color (white)
 
-            if (grid[y][x] != -1) { // If cell is filled, use a different color
+            if (grid.at(y, x) != -1) { // If cell is filled, use a different color
                 color[0] = 135; color[1] = 206; color[2] = 250;
             }
 
@@ -80,11 +52,6 @@ void saveGridImage(const vector<vector<int>>& grid, int iteration, int numOfRows
     image.save(filename.c_str());
 }
 
-
-vector<net> nets;
-int numOfRows, numOfColumns;
-vector<vector<int>> grid;
-
 bool isPositiveInteger(string word) {
     for (int i = 0; i < word.length(); i++) {
         if (!isdigit(word[i])) {
@@ -94,96 +61,21 @@ bool isPositiveInteger(string word) {
     return true;
 }
 
-void parseNetListFirstLine(string firstLine) {
-    vector<int> firstLineInts;
-    stringstream firstLineStringStream(firstLine);
-    string tempWord;
-    while(firstLineStringStream >> tempWord && isPositiveInteger(tempWord)) {
-        firstLineInts.push_back(stoi(tempWord));
-    }
-    if(firstLineInts.size() != 4) {
-        cout << "Error: first line of netlist file does not contain four space separated positive integers" << endl;
-        exit(1);
-    } else {
-        cells.resize(firstLineInts[0]);
-        for(int i = 0; i < cells.size(); i++) {
-            cells[i] = cell(i);
-        }
-        nets.resize(firstLineInts[1]);
-        numOfRows = firstLineInts[2];
-        numOfColumns = firstLineInts[3];
-        grid.resize(numOfRows);
-        for(int i = 0; i < grid.size(); i++) {
-            grid[i].resize(numOfColumns, -1);
-        }
-    }
+// reads word as an integer in [1, limit]; fails on anything else, including values that overflow an int
+bool parsePositiveInteger(const string &word, int limit, int &value) {
+    const char *end = word.data() + word.size();
+    from_chars_result result = from_chars(word.data(), end, value);
+    return !word.empty() && result.ec == errc() && result.ptr == end && value > 0 && value <= limit;
 }
 
-void parseNetListNetLine(string line, int netIndex) {
-    vector<int> netLineInts;
-    stringstream netLineStringStream(line);
-    string tempWord;
-    while(netLineStringStream >> tempWord && isPositiveInteger(tempWord)) {
-        netLineInts.push_back(stoi(tempWord));
-    }
-    if(netLineInts.size() < 1 || netLineInts.size()-1 < netLineInts[0]) {
-        cout << "Error: net line of netlist file is malformed" << endl;
-        exit(1);
-    } else {
-        nets[netIndex] = net(netIndex);
-        for(int i = 1; i < netLineInts.size(); i++) {
-            nets[netIndex].cells.push_back(netLineInts[i]);
-            cells[netLineInts[i]].nets.push_back(netIndex);
-        }
-    }
-}
-
-void parseNetListFile(string netListFileName) {
-    cout << "Parsing netlist file: " << netListFileName << endl;
-    ifstream netListFile(netListFileName);
-    if (netListFile.is_open()) {
-        string firstLine;
-        if(getline(netListFile, firstLine)) {
-            parseNetListFirstLine(firstLine);
-        }
-        string line;
-        int netIndex = 0;
-        while(getline(netListFile, line)) {
-            parseNetListNetLine(line, netIndex);
-            netIndex++;
-        }
-        netListFile.close();
-    }
-    else 
-        cout << "Unable to open file" << endl;
-}
-
-void placeInitiallyRandom() {
-    minstd_rand rng(time(0));
-    uniform_int_distribution<int> dist(0, numOfRows*numOfColumns-1);
-    for(int i = 0; i < cells.size(); i++) {
-        do {
-            int random_number = dist(rng);
-            // x is column number
-            // y is row number
-            cells[i].y = random_number / numOfColumns;
-            cells[i].x = random_number % numOfColumns;
-        } while(grid[cells[i].y][cells[i].x] != -1);
-
-        // double checking
-        if (cells[i].y < numOfRows && cells[i].x < numOfColumns) {
-            grid[cells[i].y][cells[i].x] = i;
-        } else {
-            cerr << "Error: Invalid cell position generated." << endl;
-            exit(1);
-        }
-    }
-}
+// upper bound of every option that starts one thread per unit
+const int maxThreads = 256;
 
-void printBinaryGrid() {
-    for(int i = 0; i < numOfRows; i++) {
-        for(int j = 0; j < numOfColumns; j++) {
-            if(grid[i][j] == -1) {
+void printBinaryGrid(const placement &p) {
+    const netList &design = *p.design;
+    for(int i = 0; i < design.numOfRows; i++) {
+        for(int j = 0; j < design.numOfColumns; j++) {
+            if(p.grid.at(i, j) == -1) {
                 cout << "1 ";
             } else {
                 cout << "0 ";
@@ -193,67 +85,21 @@ void printBinaryGrid() {
     }
 }
 
-int computeHPWLofNet(int netIndex) {
-    int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
-    int minXCell = -1, minYCell = -1, maxXCell = -1, maxYCell = -1;
-    for(int i = 0; i < nets[netIndex].cells.size(); i++) {
-        int cellIndex = nets[netIndex].cells[i];
-        if(cells[cellIndex].x < minX) {
-            minX = cells[cellIndex].x;
-        }
-        if(cells[cellIndex].x > maxX) {
-            maxX = cells[cellIndex].x;
-        }
-        if(cells[cellIndex].y < minY) {
-            minY = cells[cellIndex].y;
-        }
-        if(cells[cellIndex].y > maxY) {
-            maxY = cells[cellIndex].y;
-        }
-    }
-    nets[netIndex].minX = minX;
-    nets[netIndex].minXCell = minXCell;
-
-    nets[netIndex].minY = minY;
-    nets[netIndex].minYCell = minYCell;
-
-    nets[netIndex].maxX = maxX;
-    nets[netIndex].maxXCell = maxXCell;
-
-    nets[netIndex].maxY = maxY;
-    nets[netIndex].maxYCell = maxYCell;
-
-    nets[netIndex].HPWL = (maxX - minX) + (maxY - minY);
-    return nets[netIndex].HPWL;
-}
-
-void computeHPWLofAllNets() {
-    for(int i = 0; i < nets.size(); i++) {
-        computeHPWLofNet(i);
-    }
-}
-
-int computeTotalWireLength() {
-    int totalWireLength = 0;
-    for(int i = 0; i < nets.size(); i++) {
-        totalWireLength += nets[i].HPWL;
-    }
-    return totalWireLength;
-}
-
-void printGrid() {
-    for(int i = 0; i < numOfRows; i++) {
-        for(int j = 0; j < numOfColumns; j++) {
-            if(grid[i][j] == -1) {
+void printGrid(const placement &p) {
+    const netList &design = *p.design;
+    for(int i = 0; i < design.numOfRows; i++) {
+        for(int j = 0; j < design.numOfColumns; j++) {
+            int cellIndex = p.grid.at(i, j);
+            if(cellIndex == -1) {
                 cout << "----";
-            } else if(grid[i][j] < 10) {
-                cout << "000" << grid[i][j];
-            } else if(grid[i][j] < 100) {
-                cout << "00" << grid[i][j];
-            } else if(grid[i][j] < 1000) {
-                cout << "0" << grid[i][j];
+            } else if(cellIndex < 10) {
+                cout << "000" << cellIndex;
+            } else if(cellIndex < 100) {
+                cout << "00" << cellIndex;
+            } else if(cellIndex < 1000) {
+                cout << "0" << cellIndex;
             } else {
-                cout << grid[i][j];
+                cout << cellIndex;
             }
             cout << " ";
         }
@@ -261,244 +107,163 @@ void printGrid() {
     }
 }
 
-void swapCellwithCell(cell &cell1, cell &cell2) {
-    // double checking
-    // Check for valid indices before swapping
-    if (cell1.x < 0 || cell1.x >= numOfColumns || cell1.y < 0 || cell1.y >= numOfRows ||
-        cell2.x < 0 || cell2.x >= numOfColumns || cell2.y < 0 || cell2.y >= numOfRows) {
-        cerr << "Error: Invalid cell position encountered before swap." << endl;
-        cerr << "cell1.x: " << cell1.x << endl;
-        cerr << "cell1.y: " << cell1.y << endl;
-        cerr << "cell2.x: " << cell2.x << endl;
-        cerr << "cell2.y: " << cell2.y << endl;
-
-        exit(1);
-    }
-
-    int tempX = cell1.x;
-    int tempY = cell1.y;
-    cell1.x = cell2.x;
-    cell1.y = cell2.y;
-    cell2.x = tempX;
-    cell2.y = tempY;
-    grid[cell1.y][cell1.x] = cell1.id;
-    grid[cell2.y][cell2.x] = cell2.id;
-    // update HPWL of nets connected to cell1
-    for(int i = 0; i < cell1.nets.size(); i++) {
-        computeHPWLofNet(cell1.nets[i]);
-    }
-    // update HPWL of nets connected to cell2
-    for(int i = 0; i < cell2.nets.size(); i++) {
-        computeHPWLofNet(cell2.nets[i]);
-    }
+void printCell(const placement &p, int cellIndex) {
+    cout << "Cell id: " << cellIndex << " row: " << p.cellY[cellIndex] << " column: " << p.cellX[cellIndex] << endl;
 }
 
+void writeCoolingRateGraphs(const vector<sweepResult> &results) {
+    //Final Wirelength vs Cooling Rate
+    ofstream myfile;
+    myfile.open ("CoolingRate_TWL.csv");
+    myfile << "Cooling Rate,Run,Wirelength\n";
+    for (int i = 0; i < results.size(); i++) {
+        myfile << results[i].coolingRate << "," << results[i].run << "," << results[i].finalWireLength << "\n";
+    }
+    myfile.close();
 
-void swapCellWithEmpty(cell &cell1, int emptyY, int emptyX) {
-    int tempX = cell1.x;
-    int tempY = cell1.y;
-    cell1.x = emptyX;
-    cell1.y = emptyY;
-    grid[cell1.y][cell1.x] = cell1.id;
-    grid[tempY][tempX] = -1;
-    // update HPWL of nets connected to cell1
-    for(int i = 0; i < cell1.nets.size(); i++) {
-        computeHPWLofNet(cell1.nets[i]);
+    //All Wirelength vs Temperature for different cooling rates
+    myfile.open ("CoolingRate_Temp_TWL.csv");
+    traceRecorder::writeStepHeader(myfile, "Cooling Rate,Run,");
+    for (int i = 0; i < results.size(); i++) {
+        myfile << results[i].stepRows;
     }
+    myfile.close();
 }
 
-void swapCells(int cell1Index, int cell2Index, int cell1Row, int cell1Column, int cell2Row, int cell2Column) {
-    if (cell1Index >=0 && cell1Index < cells.size() && cell2Index >= 0 && cell2Index < cells.size()) {
-        // Swap two cells that are filled
-        swapCellwithCell(cells[cell1Index], cells[cell2Index]);
-    } else  if (cell1Index >=0 && cell1Index < cells.size() && cell2Index == -1){
-        // Swap a filled cell with an empty position
-        swapCellWithEmpty(cells[cell1Index], cell2Row, cell2Column);
-    } else if (cell2Index >=0 && cell2Index < cells.size() && cell1Index == -1) {
-        // Swap an empty position with a filled cell
-        swapCellWithEmpty(cells[cell2Index], cell1Row, cell1Column);
-    } else if (cell1Index == -1 && cell2Index == -1) {
-        // Both positions are empty, no swap needed
-        return;
-    } else {
-        cerr << "Error: Invalid cell index generated." << endl;
-        cerr << "cells size: " << cells.size() << endl;
-        cerr << "cell1Index: " << cell1Index << endl;
-        cerr << "cell2Index: " << cell2Index << endl;
-        exit(1);
-    }
+bool sameBox(const boundingBox &a, const boundingBox &b) {
+    return a.minX == b.minX && a.maxX == b.maxX && a.minY == b.minY && a.maxY == b.maxY &&
+           a.minXCount == b.minXCount && a.maxXCount == b.maxXCount &&
+           a.minYCount == b.minYCount && a.maxYCount == b.maxYCount && a.HPWL == b.HPWL;
 }
 
-bool detectTwoEmptyCells() {
-    int emptyCellCount = 0;
-    for(int i = 0; i < numOfRows; i++) {
-        for(int j = 0; j < numOfColumns; j++) {
-            if(grid[i][j] == -1) {
-                emptyCellCount++;
-                if(emptyCellCount == 2) {
-                    return true;
-                }
-            }
+// times the bounding-box kernels on a random placement: the nets of a set through the kernel of
+// every instruction set the processor supports, checked against the scalar boxes, and the full
+// recomputation computeHPWLofAllNets() does. Returns false when a kernel disagrees.
+bool benchmarkHPWLKernels(const netList &design, int repeats) {
+    placement p;
+    resetPlacement(p, design);
+    if (!placeInitiallyRandom(p, 1)) {
+        cerr << "Error: netlist has more cells than grid sites." << endl;
+        return false;
+    }
+    vector<int> allNets, twoPinNets, wideNets;
+    long long allPins = 0, twoPins = 0, widePins = 0;
+    for (int i = 0; i < design.numOfNets; i++) {
+        int degree = design.netPinStart[i + 1] - design.netPinStart[i];
+        allNets.push_back(i);
+        allPins += degree;
+        if (degree == 2) {
+            twoPinNets.push_back(i);
+            twoPins += degree;
+        } else if (degree > 8) {
+            wideNets.push_back(i);
+            widePins += degree;
         }
     }
-    return false;
-}
-
-void printCell(cell cell1) {
-    cout << "Cell id: " << cell1.id << " row: " << cell1.y << " column: " << cell1.x << endl;
-}
-
-
-void simulateAnnealingFast(int initialCost) {
-    double initialTemperature = 500*initialCost;
-    double finalTemperature = 0.000005*initialCost/nets.size();
-    double currentTemperature = initialTemperature;
-    int moves = 10*cells.size();
-    minstd_rand rng(time(0));
-    uniform_int_distribution<int> intRowsRange(0, numOfRows-1);
-    uniform_int_distribution<int> intColumnsRange(0, numOfColumns-1);
-    uniform_real_distribution<double> doubleDist(0, 1);
-
-    int cell1Row, cell1Column, cell2Row, cell2Column;
-    int cell1Index, cell2Index;
-    int initialTotalHPWL, newTotalHPWL, deltaHPWL;
-    double probability, random_number;
-    int count = 0;
-
-    while(currentTemperature > finalTemperature) {
-        for(int i = 0; i < moves; i++) {
-            cell1Row = intRowsRange(rng);
-            cell1Column = intColumnsRange(rng);
-            cell2Row = intRowsRange(rng);
-            cell2Column = intColumnsRange(rng);
-
-            cell1Index = grid[cell1Row][cell1Column];
-            cell2Index = grid[cell2Row][cell2Column];
-
-            initialTotalHPWL = computeTotalWireLength();
-            swapCells(cell1Index, cell2Index, cell1Row, cell1Column, cell2Row, cell2Column);
-            newTotalHPWL = computeTotalWireLength();
-            deltaHPWL = newTotalHPWL - initialTotalHPWL;
-            if(deltaHPWL >= 0) {
-                probability = exp(-1*(double)deltaHPWL/currentTemperature); 
-                random_number = doubleDist(rng);
-                if(random_number > probability) {
-                    swapCells(cell1Index, cell2Index, cell2Row, cell2Column, cell1Row, cell1Column);
+    if (repeats == 0) {
+        repeats = max(1LL, 50000000 / max(1LL, allPins));
+    }
+    cout << "Default kernel: " << hpwlKernelName(detectHPWLKernel()) << endl;
+    cout << design.numOfNets << " nets, " << allPins << " pins, " << twoPinNets.size() << " 2-pin nets, "
+         << wideNets.size() << " nets of more than 8 pins, " << repeats << " repeats" << endl;
+    cout << fixed << setprecision(3);
+    vector<pair<string, const vector<int> *>> sets = {{"all nets", &allNets}, {"2-pin nets", &twoPinNets}, {"nets of 9+ pins", &wideNets}};
+    vector<long long> setPins = {allPins, twoPins, widePins};
+    for (int s = 0; s < sets.size(); s++) {
+        const vector<int> &nets = *sets[s].second;
+        long long pins = setPins[s];
+        if (pins == 0) {
+            continue;
+        }
+        computeHPWLofNets(p, nets, SCALAR_HPWL);
+        vector<boundingBox> expected = p.nets;
+        for (hpwlKernel kernel : {SCALAR_HPWL, AVX2_HPWL, AVX512_HPWL}) {
+            if (!hpwlKernelSupported(kernel)) {
+                continue;
+            }
+            auto start = high_resolution_clock::now();
+            for (int r = 0; r < repeats; r++) {
+                computeHPWLofNets(p, nets, kernel);
+            }
+            double seconds = duration<double>(high_resolution_clock::now() - start).count();
+            for (int i = 0; i < nets.size(); i++) {
+                if (!sameBox(p.nets[nets[i]], expected[nets[i]])) {
+                    cerr << "Error: " << hpwlKernelName(kernel) << " box of net " << nets[i] << " differs from the scalar one" << endl;
+                    return false;
                 }
             }
+            cout << sets[s].first << ", " << hpwlKernelName(kernel) << ": " << seconds * 1e9 / (pins * repeats) << " ns per pin, "
+                 << pins * repeats / seconds / 1e6 << " million pins per second" << endl;
         }
-        currentTemperature = 0.95 * currentTemperature;
-    }
-}
-
-vector <double> temperatures;
-vector <int> wireLengths;
-
-void simulateAnnealing(int initialCost, double coolingRate) {
-    double initialTemperature = 500*initialCost;
-    double finalTemperature = 0.000005*initialCost/nets.size();
-    double currentTemperature = initialTemperature;
-    int moves = 10*cells.size();
-    // int moves = 5;
-    minstd_rand rng(time(0));
-    uniform_int_distribution<int> intRowsRange(0, numOfRows-1);
-    uniform_int_distribution<int> intColumnsRange(0, numOfColumns-1);
-    uniform_real_distribution<double> doubleDist(0, 1);
-
-    int cell1Row, cell1Column, cell2Row, cell2Column;
-    int cell1Index, cell2Index;
-    int initialTotalHPWL, newTotalHPWL, deltaHPWL;
-    double probability, random_number;
-    int count = 0;
-
-
-    while(currentTemperature > finalTemperature) {
-        for(int i = 0; i < moves; i++) {
-            // randomly select 2 cells
-            cell1Row = intRowsRange(rng);
-            cell1Column = intColumnsRange(rng);
-            cell2Row = intRowsRange(rng);
-            cell2Column = intColumnsRange(rng);
-
-            cell1Index = grid[cell1Row][cell1Column];
-            cell2Index = grid[cell2Row][cell2Column];
-
-            initialTotalHPWL = computeTotalWireLength();
-          
-            swapCells(cell1Index, cell2Index, cell1Row, cell1Column, cell2Row, cell2Column);
-            
-            newTotalHPWL = computeTotalWireLength();
-            wireLengths.push_back(newTotalHPWL);
-            deltaHPWL = newTotalHPWL - initialTotalHPWL;
-            if(deltaHPWL >= 0) {
-                
-                probability = exp(-1*(double)deltaHPWL/currentTemperature); 
-                random_number = doubleDist(rng);
-                if(random_number > probability) {
-                  
-                    swapCells(cell1Index, cell2Index, cell2Row, cell2Column, cell1Row, cell1Column);
-                  
-                }
+        // computeHPWLofNet() takes 2-pin nets in closed form and sends the others to the default kernel
+        auto start = high_resolution_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            for (int netIndex : nets) {
+                computeHPWLofNet(p, netIndex);
             }
         }
-        
-        // generate images for GIF
-        // saveGridImage(grid, count, numOfRows, numOfColumns, 50); // 50x50 pixels per cell
-        count++;
-        currentTemperature = coolingRate * currentTemperature;
-        temperatures.push_back(currentTemperature);
-    }
-}
-
-void HPWL_Temperature_Graph(){
-    ofstream myfile;
-    myfile.open ("Temp_TWL.csv");
-    myfile << "Temperature,Wirelength\n";
-    for (int i = 0; i < temperatures.size(); i++) {
-        myfile << temperatures[i] << "," << wireLengths[i] << "\n";
-    }
-    myfile.close();
-
-}
-
-void Final_Wirelength_CoolingRate_Graph(double coolingRates[5]){
-    vector <int> wireLengthsForDifferentCoolingRates;
-    
-    ofstream myfile;
-    for (int i = 0; i < 5; i++) {
-        wireLengths.clear();
-        temperatures.clear();
-        simulateAnnealing(computeTotalWireLength(), coolingRates[i]);
-        wireLengthsForDifferentCoolingRates.push_back(computeTotalWireLength());
-    }
-    myfile.open ("CoolingRate_TWL.csv");
-    myfile << "Cooling Rate,Wirelength\n";
-    for (int i = 0; i < 5; i++) {
-        myfile << coolingRates[i] << "," << wireLengthsForDifferentCoolingRates[i] << "\n";
-    }
-    myfile.close();
-}
-
-void HPWL_Wirelength_CoolingRate_Graph(double coolingRates[5]) {
-    
-    ofstream myfile;
-    myfile.open ("CoolingRate_Temp_TWL.csv");
-    myfile << "Cooling Rate,Temperature, Wirelength\n";
-    for (int i = 0; i < 5; i++) {
-        simulateAnnealing(computeTotalWireLength(), coolingRates[i]);
-        for (int j = 0; j < temperatures.size(); j++) {
-            myfile << coolingRates[i] << "," << temperatures[j] << "," << wireLengths[j] << "\n";
+        double seconds = duration<double>(high_resolution_clock::now() - start).count();
+        for (int i = 0; i < nets.size(); i++) {
+            if (!sameBox(p.nets[nets[i]], expected[nets[i]])) {
+                cerr << "Error: computeHPWLofNet box of net " << nets[i] << " differs from the scalar one" << endl;
+                return false;
+            }
         }
-        wireLengths.clear();
-        temperatures.clear();
+        cout << sets[s].first << ", computeHPWLofNet: " << seconds * 1e9 / (pins * repeats) << " ns per pin, "
+             << pins * repeats / seconds / 1e6 << " million pins per second" << endl;
     }
-    myfile.close();
+    return true;
 }
 
 int main(int argc, char* argv[]) {
+    // conversion of a netlist to the binary format, nothing is placed
+    if (argc == 4 && string(argv[1]) == "--convert") {
+        netList design;
+        if (!parseNetListFile(design, argv[2], 0, false)) {
+            return 1;
+        }
+        if (!writeBinaryNetList(design, argv[3])) {
+            cerr << "Unable to write " << argv[3] << endl;
+            return 1;
+        }
+        cout << "Wrote binary netlist: " << argv[3] << endl;
+        return 0;
+    }
+    // micro-benchmark of the bounding-box kernels, nothing is annealed
+    if ((argc == 3 || argc == 4) && string(argv[1]) == "--bench-hpwl") {
+        int repeats = 0;
+        if (argc == 4) {
+            if (!parsePositiveInteger(argv[3], 999999999, repeats)) {
+                cerr << "Invalid number of repeats. Please enter a positive integer." << endl;
+                return 1;
+            }
+        }
+        netList design;
+        if (!parseNetListFile(design, argv[2], 0, false)) {
+            return 1;
+        }
+        return benchmarkHPWLKernels(design, repeats) ? 0 : 1;
+    }
         // Check if the correct number of arguments are provided
-    if (argc != 3) {
-        cerr << "Usage: " << argv[0] << " <netlist file name> <y/n for CSV output for graphs>" << endl;
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <netlist file name> <y/n for CSV output for graphs> [options]" << endl;
+        cerr << "       " << argv[0] << " --convert <netlist file name> <binary netlist file name>" << endl;
+        cerr << "       " << argv[0] << " --bench-hpwl <netlist file name> [repeats]" << endl;
+        cerr << "Options:" << endl;
+        cerr << "  --schedule geometric|adaptive   cooling schedule (default geometric)" << endl;
+        cerr << "  --calibrate                     derive the temperature range from sampled moves" << endl;
+        cerr << "  --starts N                      run N independent placements and keep the best (default 1)" << endl;
+        cerr << "  --threads K                     worker threads for --starts and the cooling-rate sweep (default: one per core)" << endl;
+        cerr << "  --replicas K                    parallel tempering with K replicas, one thread each" << endl;
+        cerr << "  --exchanges E                   replica exchange rounds for --replicas (default 500)" << endl;
+        cerr << "  --regions K                     anneal one placement with K threads on disjoint grid regions" << endl;
+        cerr << "  --hogwild K                     anneal one placement with K lock-free threads (not reproducible)" << endl;
+        cerr << "  --spec-threads K                evaluate the low-acceptance tail speculatively on K threads" << endl;
+        cerr << "  --seed S                        seed of the run (default: current time)" << endl;
+        cerr << "  --parse-threads K               threads parsing the netlist (default: one per 8 MB, up to one per core)" << endl;
+        cerr << "  --no-cache                      neither read nor write the binary cache of a large netlist" << endl;
+        cerr << "  --sweep-runs N                  with CSV output, anneal every cooling rate N times (default 1)" << endl;
+        cerr << "  --trace-samples N               with CSV output, also sample N per-move wire lengths into Move_TWL.csv" << endl;
         return 1;
     }
 
@@ -511,23 +276,247 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    coolingSchedule schedule = GEOMETRIC_COOLING;
+    bool calibrate = false;
+    int starts = 1;
+    int threads = 0;
+    int replicas = 0;
+    int exchanges = 500;
+    int regions = 0;
+    int hogwildThreads = 0;
+    int speculativeThreads = 0;
+    int parseThreads = 0;
+    bool useCache = true;
+    int traceSamples = 0;
+    int sweepRuns = 1;
+    uint64_t baseSeed = time(0);
+    vector<string> givenOptions; // options on the command line that only some run modes honour
+    for (int i = 3; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--schedule" && i + 1 < argc) {
+            string value = argv[++i];
+            if (value == "geometric") {
+                schedule = GEOMETRIC_COOLING;
+            } else if (value == "adaptive") {
+                schedule = ADAPTIVE_COOLING;
+            } else {
+                cerr << "Invalid schedule. Please enter 'geometric' or 'adaptive'." << endl;
+                return 1;
+            }
+            givenOptions.push_back(option);
+        } else if (option == "--calibrate") {
+            calibrate = true;
+            givenOptions.push_back(option);
+        } else if (option == "--no-cache") {
+            useCache = false;
+        } else if (option == "--seed" && i + 1 < argc) {
+            string value = argv[++i];
+            if (value.empty() || !isPositiveInteger(value) || value.size() > 20 ||
+                (value.size() == 20 && value > "18446744073709551615")) {
+                cerr << "Invalid value for --seed. Please enter a non-negative integer." << endl;
+                return 1;
+            }
+            baseSeed = stoull(value);
+        } else if ((option == "--starts" || option == "--threads" || option == "--replicas" || option == "--exchanges" || option == "--regions" ||
+                    option == "--hogwild" || option == "--spec-threads" || option == "--parse-threads" ||
+                    option == "--trace-samples" || option == "--sweep-runs") && i + 1 < argc) {
+            string value = argv[++i];
+            bool threadCount = option == "--threads" || option == "--replicas" || option == "--regions" ||
+                               option == "--hogwild" || option == "--spec-threads" || option == "--parse-threads";
+            int limit = threadCount ? maxThreads : option == "--exchanges" ? INT_MAX : 10000000;
+            int number;
+            if (!parsePositiveInteger(value, limit, number)) {
+                cerr << "Invalid value for " << option << ". Please enter a positive integer no greater than " << limit << "." << endl;
+                return 1;
+            }
+            if (option == "--starts") {
+                starts = number;
+            } else if (option == "--threads") {
+                threads = number;
+            } else if (option == "--replicas") {
+                replicas = number;
+            } else if (option == "--regions") {
+                regions = number;
+            } else if (option == "--hogwild") {
+                hogwildThreads = number;
+            } else if (option == "--spec-threads") {
+                speculativeThreads = number;
+            } else if (option == "--parse-threads") {
+                parseThreads = number;
+            } else if (option == "--trace-samples") {
+                traceSamples = number;
+            } else if (option == "--sweep-runs") {
+                sweepRuns = number;
+            } else {
+                exchanges = number;
+            }
+            givenOptions.push_back(option);
+        } else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+
+    // options every run mode does not honour are rejected instead of silently ignored
+    bool csvOutput = choice == 'y' || choice == 'Y';
+    auto given = [&](const string &option) { return find(givenOptions.begin(), givenOptions.end(), option) != givenOptions.end(); };
+    vector<string> modes;
+    for (string mode : {"--replicas", "--regions", "--hogwild"}) {
+        if (given(mode)) {
+            modes.push_back(mode);
+        }
+    }
+    if (starts > 1) {
+        modes.push_back("--starts");
+    }
+    if (modes.size() > 1) {
+        cerr << "Invalid options: " << modes[0] << " and " << modes[1] << " select different run modes. Please pick one." << endl;
+        return 1;
+    }
+    if (!modes.empty() && given("--spec-threads")) {
+        cerr << "Invalid options: --spec-threads only applies to a single sequential run, not to " << modes[0] << "." << endl;
+        return 1;
+    }
+    if (speculativeThreads == 1) {
+        cerr << "Invalid value for --spec-threads. Speculation needs at least 2 threads." << endl;
+        return 1;
+    }
+    if (!modes.empty() && csvOutput) {
+        cerr << "Invalid options: the Temp_TWL.csv trace is only recorded for a single sequential run, not for " << modes[0]
+             << ". Please enter 'n' for CSV output." << endl;
+        return 1;
+    }
+    if (given("--exchanges") && !given("--replicas")) {
+        cerr << "Invalid options: --exchanges only applies to --replicas." << endl;
+        return 1;
+    }
+    for (string option : {"--schedule", "--calibrate"}) {
+        // the replicas anneal at fixed temperatures of a ladder that is always calibrated
+        if (given(option) && given("--replicas")) {
+            cerr << "Invalid options: " << option << " does not apply to --replicas." << endl;
+            return 1;
+        }
+    }
+    if (given("--threads") && starts == 1 && !csvOutput) {
+        cerr << "Invalid options: --threads only applies to --starts with N > 1 or to 'y' for CSV output." << endl;
+        return 1;
+    }
+    for (string option : {"--trace-samples", "--sweep-runs"}) {
+        if (given(option) && !csvOutput) {
+            cerr << "Invalid options: " << option << " only applies with 'y' for CSV output." << endl;
+            return 1;
+        }
+    }
+
     cout << "Welcome to Simulated Annealing Project" << endl;
 
     //start timer
     auto start = high_resolution_clock::now();
-    double coolingRates[] = {0.95, 0.9, 0.85, 0.8, 0.75};
-
-    parseNetListFile(netListFileName);
-    placeInitiallyRandom();
-    printBinaryGrid();
-    computeHPWLofAllNets();
-    cout << "Initial Total wire length: " << computeTotalWireLength() << endl;
-    cout << endl << endl;
-    simulateAnnealingFast(computeTotalWireLength());
+    vector<double> coolingRates = {0.95, 0.9, 0.85, 0.8, 0.75};
+
+    netList design;
+    if (!parseNetListFile(design, netListFileName, parseThreads, useCache)) {
+        return 1;
+    }
+    cout << "Seed: " << baseSeed << endl;
+    placement mainPlacement;
+    unique_ptr<speculativeAnnealer> speculation;
+    if (speculativeThreads > 1) {
+        speculation.reset(new speculativeAnnealer(speculativeThreads));
+    }
+    // the convergence trace of a single run is streamed to Temp_TWL.csv while it anneals
+    ofstream temperatureFile;
+    unique_ptr<traceRecorder> trace;
+    if (csvOutput) {
+        temperatureFile.open("Temp_TWL.csv");
+        traceRecorder::writeStepHeader(temperatureFile);
+        trace.reset(new traceRecorder(&temperatureFile, baseSeed, traceSamples));
+    }
+    int temperatureSteps;
+    if (replicas > 0) {
+        // calibrate the ladder on a throwaway random placement
+        resetPlacement(mainPlacement, design);
+        if (!placeInitiallyRandom(mainPlacement, baseSeed)) {
+            cerr << "Error: netlist has more cells than grid sites." << endl;
+            return 1;
+        }
+        computeHPWLofAllNets(mainPlacement);
+        temperatureRange range = calibrateTemperatureRange(mainPlacement, 4000, baseSeed);
+        cout << "Running " << replicas << " replicas between temperatures " << range.finalTemperature
+             << " and " << range.initialTemperature << " for " << exchanges << " exchange rounds" << endl;
+        temperingResult result = runParallelTempering(design, mainPlacement, replicas, exchanges, range, baseSeed);
+        if (!result.placed) {
+            cerr << "Error: netlist has more cells than grid sites." << endl;
+            return 1;
+        }
+        cout << "Accepted exchanges: " << result.acceptedExchanges << " of " << result.attemptedExchanges << endl;
+        temperatureSteps = -1; // fixed temperatures, no cooling steps
+    } else if (starts == 1) {
+        resetPlacement(mainPlacement, design);
+        if (!placeInitiallyRandom(mainPlacement, baseSeed)) {
+            cerr << "Error: netlist has more cells than grid sites." << endl;
+            return 1;
+        }
+        printBinaryGrid(mainPlacement);
+        computeHPWLofAllNets(mainPlacement);
+        cout << "Initial Total wire length: " << mainPlacement.totalWireLength << endl;
+        cout << endl << endl;
+        temperatureRange range = legacyTemperatureRange(*mainPlacement.design, mainPlacement.totalWireLength);
+        if (calibrate) {
+            temperatureRange calibratedRange = calibrateTemperatureRange(mainPlacement, 4000, baseSeed);
+            int legacySteps = geometricSteps(range, 0.95);
+            int calibratedSteps = geometricSteps(calibratedRange, 0.95);
+            cout << "Calibrated temperatures: " << calibratedRange.initialTemperature << " -> " << calibratedRange.finalTemperature
+                 << " (legacy " << range.initialTemperature << " -> " << range.finalTemperature << ")" << endl;
+            cout << "Geometric steps: " << calibratedSteps << " instead of " << legacySteps
+                 << ", " << legacySteps - calibratedSteps << " saved" << endl;
+            range = calibratedRange;
+        }
+        if (regions > 0) {
+            cout << "Annealing on " << regions << " regions" << endl;
+            temperatureSteps = simulateAnnealingRegions(mainPlacement, range, schedule, regions, baseSeed);
+        } else if (hogwildThreads > 0) {
+            cout << "Annealing lock-free on " << hogwildThreads << " threads" << endl;
+            temperatureSteps = simulateAnnealingHogwild(mainPlacement, range, schedule, hogwildThreads, baseSeed);
+        } else {
+            temperatureSteps = simulateAnnealingFast(mainPlacement, range, schedule, baseSeed, speculation.get(), trace.get());
+            if (speculation) {
+                cout << "Speculative moves re-evaluated after a conflict: " << speculation->reevaluatedMoves << endl;
+            }
+        }
+    } else {
+        if (threads == 0) {
+            threads = max(1, (int)thread::hardware_concurrency());
+        }
+        threads = min(threads, starts);
+        cout << "Running " << starts << " starts on " << threads << " threads" << endl;
+        vector<startResult> results = runMultiStart(design, starts, threads, schedule, calibrate, baseSeed, mainPlacement);
+        if (!results[0].placed) {
+            // every start places the same netlist, so either all of them fit or none does
+            cerr << "Error: netlist has more cells than grid sites." << endl;
+            return 1;
+        }
+        int bestStart = 0;
+        for (int i = 0; i < results.size(); i++) {
+            cout << "Start " << results[i].start << ": seed " << results[i].seed
+                 << ", initial wire length " << results[i].initialWireLength
+                 << ", final wire length " << results[i].finalWireLength
+                 << ", " << results[i].temperatureSteps << " temperature steps, "
+                 << fixed << setprecision(3) << results[i].seconds << " seconds" << endl;
+            if (results[i].finalWireLength < results[bestStart].finalWireLength) {
+                bestStart = i;
+            }
+        }
+        cout << "Best start: " << bestStart << endl;
+        temperatureSteps = results[bestStart].temperatureSteps;
+    }
     //stop timer
     auto stop = high_resolution_clock::now();
-    printGrid();
-    cout << "Final Total wire length: " << computeTotalWireLength() << endl;
+    printGrid(mainPlacement);
+    cout << "Final Total wire length: " << computeTotalWireLength(mainPlacement) << endl;
+    if (temperatureSteps >= 0) {
+        cout << "Temperature steps: " << temperatureSteps << endl;
+    }
 
     //calculate duration in milliseconds
     auto duration = duration_cast<milliseconds>(stop - start);
@@ -539,19 +528,29 @@ int main(int argc, char* argv[]) {
              << duration.count() / 1000 << " seconds" << endl;
     }
 
-    if(choice == 'y' || choice == 'Y') {
-        //Wirelength vs Temperature
-        HPWL_Temperature_Graph();
-
-        //Final Wirelength vs Cooling Rate
-        Final_Wirelength_CoolingRate_Graph(coolingRates);
+    if(csvOutput) {
+        //Wirelength vs Temperature, written during the run
+        temperatureFile.close();
+        if (traceSamples > 0) {
+            ofstream sampleFile("Move_TWL.csv");
+            trace->writeSamples(sampleFile);
+        }
 
-        //All Wirelength vs Temperature for different cooling rates
-        HPWL_Wirelength_CoolingRate_Graph(coolingRates);
+        // every rate anneals a copy of the random placement the main run started from
+        placement sweepStart;
+        resetPlacement(sweepStart, design);
+        if (!placeInitiallyRandom(sweepStart, baseSeed)) {
+            cerr << "Error: netlist has more cells than grid sites." << endl;
+            return 1;
+        }
+        computeHPWLofAllNets(sweepStart);
+        int sweepThreads = threads > 0 ? threads : max(1, (int)thread::hardware_concurrency());
+        vector<sweepResult> sweep = runCoolingRateSweep(sweepStart, coolingRates, sweepRuns, sweepThreads, baseSeed);
+        writeCoolingRateGraphs(sweep);
     }
 
     return 0;
 }
 
-//g++ main.cpp -O3 -lX11 -lpthread -std=c++17 -march=native -funroll-loops -ffast-math -o main
-//convert -delay 5 -loop 0 GIF_input_images/grid_*.png output.gif
\ No newline at end of file
+//g++ main.cpp placer.cpp -O3 -lX11 -lpthread -std=c++17 -march=native -funroll-loops -ffast-math -o main
+//convert -delay 5 -loop 0 GIF_input_images/grid_*.png output.gif
@@ -0,0 +1,1713 @@
+#include "placer.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <iomanip>
+#include <memory>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+uint64_t deriveSeed(uint64_t seed, seedStream stream, uint64_t index) {
+    uint64_t z = seed;
+    uint64_t parts[2] = { (uint64_t)stream, index };
+    for (int i = 0; i < 2; i++) {
+        z += 0x9e3779b97f4a7c15ULL + parts[i];
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+    }
+    return z;
+}
+
+// read-only view of a whole file, memory-mapped so the parser scans the page cache in place;
+// pipes, terminals and other inputs that cannot be mapped are read into a buffer instead
+struct mappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    string buffer;
+
+    bool open(const string &fileName) {
+        int descriptor = ::open(fileName.c_str(), O_RDONLY);
+        if (descriptor == -1) {
+            return false;
+        }
+        struct stat status;
+        bool opened = fstat(descriptor, &status) == 0;
+        if (opened && !S_ISREG(status.st_mode)) {
+            opened = readAll(descriptor);
+        } else if (opened && status.st_size > 0) {
+            void *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                opened = false;
+            } else {
+                data = (const char *)mapping;
+                size = status.st_size;
+                mapped = true;
+                madvise(mapping, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(descriptor);
+        return opened;
+    }
+
+    ~mappedFile() {
+        if (mapped) {
+            munmap((void *)data, size);
+        }
+    }
+
+private:
+    bool readAll(int descriptor) {
+        char block[1 << 16];
+        while (true) {
+            ssize_t count = read(descriptor, block, sizeof(block));
+            if (count == 0) {
+                break;
+            } else if (count < 0 && errno != EINTR) {
+                return false;
+            } else if (count > 0) {
+                buffer.append(block, count);
+            }
+        }
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+    }
+};
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// reads the next whitespace-separated token of the line ending at lineEnd as an integer, in place;
+// fails at the end of the line and, like the stream parser before it, at the first token that is
+// not made of digits only or does not fit an int
+static bool nextInteger(const char *&cursor, const char *lineEnd, int &value) {
+    while (cursor < lineEnd && isBlank(*cursor)) {
+        cursor++;
+    }
+    const char *tokenBegin = cursor;
+    while (cursor < lineEnd && !isBlank(*cursor)) {
+        cursor++;
+    }
+    if (tokenBegin == cursor) {
+        return false;
+    }
+    from_chars_result result = from_chars(tokenBegin, cursor, value);
+    return result.ec == errc() && result.ptr == cursor && *tokenBegin != '-' && *tokenBegin != '+';
+}
+
+static const char *endOfLine(const char *begin, const char *end) {
+    if (begin == end) {
+        return end;
+    }
+    const char *newline = (const char *)memchr(begin, '\n', end - begin);
+    return newline == nullptr ? end : newline;
+}
+
+static bool parseNetListFirstLine(netList &design, const char *line, const char *lineEnd) {
+    int firstLineInts[4];
+    int count = 0, value;
+    while (nextInteger(line, lineEnd, value)) {
+        if (count < 4) {
+            firstLineInts[count] = value;
+        }
+        count++;
+    }
+    if(count != 4) {
+        cout << "Error: first line of netlist file does not contain four space separated positive integers" << endl;
+        return false;
+    } else {
+        design.numOfCells = firstLineInts[0];
+        design.numOfNets = firstLineInts[1];
+        design.netPinStart.assign(1, 0);
+        design.netPins.clear();
+        design.numOfRows = firstLineInts[2];
+        design.numOfColumns = firstLineInts[3];
+    }
+    return true;
+}
+
+// drops repeated cells of one net in place, keeping the first occurrence of each, and returns the
+// new pin count; short nets are checked pairwise, long ones against a sorted copy
+static int removeDuplicatePins(int *pins, int count, vector<int> &sorted) {
+    if (count <= 16) {
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            bool repeated = false;
+            for (int j = 0; j < kept && !repeated; j++) {
+                repeated = pins[j] == pins[i];
+            }
+            if (!repeated) {
+                pins[kept++] = pins[i];
+            }
+        }
+        return kept;
+    }
+    sorted.assign(pins, pins + count);
+    sort(sorted.begin(), sorted.end());
+    if (adjacent_find(sorted.begin(), sorted.end()) == sorted.end()) {
+        return count;
+    }
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+    vector<bool> taken(sorted.size(), false);
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        int slot = lower_bound(sorted.begin(), sorted.end(), pins[i]) - sorted.begin();
+        if (!taken[slot]) {
+            taken[slot] = true;
+            pins[kept++] = pins[i];
+        }
+    }
+    return kept;
+}
+
+// a run of whole net lines [begin, end) of the file, parsed by one thread into arrays of its own;
+// lines are separated by newlines, so a chunk with lines holds one more line than newlines
+struct netListChunk {
+    const char *begin, *end;
+    bool hasLines = false;
+    int numOfCells;      // cells of the netlist, pins must be below it
+    vector<int> pins;    // pins of the chunk's nets back to back
+    vector<int> pinEnds; // end of every net's pins in pins
+    vector<int> sorted;  // scratch of removeDuplicatePins()
+    int errorLine = -1;  // first bad line, counted from the start of the chunk
+    int errorCell = -1;  // the unknown cell it refers to, -1 when the line is malformed
+};
+
+// appends the pins of one net line to chunk.pins; returns false and records the error on a bad line
+static bool parseNetListNetLine(const char *line, const char *lineEnd, netListChunk &chunk) {
+    int declaredPins, cellIndex;
+    int listedPins = 0;
+    size_t firstPin = chunk.pins.size();
+    bool hasCount = nextInteger(line, lineEnd, declaredPins);
+    if (hasCount) {
+        while (nextInteger(line, lineEnd, cellIndex)) {
+            listedPins++;
+            if (cellIndex >= chunk.numOfCells) {
+                chunk.errorLine = chunk.pinEnds.size();
+                chunk.errorCell = cellIndex;
+                return false;
+            }
+            chunk.pins.push_back(cellIndex);
+        }
+    }
+    if(!hasCount || listedPins < declaredPins) {
+        chunk.errorLine = chunk.pinEnds.size();
+        return false;
+    }
+    int keptPins = removeDuplicatePins(chunk.pins.data() + firstPin, listedPins, chunk.sorted);
+    chunk.pins.resize(firstPin + keptPins);
+    chunk.pinEnds.push_back(chunk.pins.size());
+    return true;
+}
+
+// two passes over a chunk: the first counts tokens so pins is allocated once, the second converts
+// the integers in place into it
+static void parseNetListChunk(netListChunk &chunk) {
+    if (!chunk.hasLines) {
+        return;
+    }
+    size_t tokens = 0;
+    bool inToken = false;
+    for (const char *c = chunk.begin; c < chunk.end; c++) {
+        if (*c == '\n' || isBlank(*c)) {
+            inToken = false;
+        } else if (!inToken) {
+            tokens++;
+            inToken = true;
+        }
+    }
+    chunk.pins.reserve(tokens);
+    const char *line = chunk.begin;
+    while (true) {
+        const char *lineEnd = endOfLine(line, chunk.end);
+        if (!parseNetListNetLine(line, lineEnd, chunk) || lineEnd == chunk.end) {
+            return;
+        }
+        line = lineEnd + 1;
+    }
+}
+
+// runs job(0) .. job(threads - 1) in parallel, job(0) on the calling thread
+static void runOnThreads(int threads, const function<void(int)> &job) {
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(job, t);
+    }
+    job(0);
+    for (int t = 0; t < pool.size(); t++) {
+        pool[t].join();
+    }
+}
+
+// builds the cell -> nets index from the net -> cells pins with a counting pass and a prefix sum;
+// with several threads the counts and slots are claimed atomically and the nets of every cell are
+// sorted afterwards, which gives the index the sequential pass builds
+static void buildCellNets(netList &design, int threads) {
+    // nets missing from the file are left without pins
+    while (design.netPinStart.size() < design.numOfNets + 1) {
+        design.netPinStart.push_back(design.netPins.size());
+    }
+    design.cellNetStart.assign(design.numOfCells + 1, 0);
+    design.cellNets.resize(design.netPins.size());
+    if (threads == 1) {
+        for(int i = 0; i < design.netPins.size(); i++) {
+            design.cellNetStart[design.netPins[i] + 1]++;
+        }
+        for(int i = 0; i < design.numOfCells; i++) {
+            design.cellNetStart[i + 1] += design.cellNetStart[i];
+        }
+        vector<int> nextSlot(design.cellNetStart.begin(), design.cellNetStart.end() - 1);
+        for(int netIndex = 0; netIndex < design.numOfNets; netIndex++) {
+            for(int i = design.netPinStart[netIndex]; i < design.netPinStart[netIndex + 1]; i++) {
+                design.cellNets[nextSlot[design.netPins[i]]++] = netIndex;
+            }
+        }
+        return;
+    }
+    vector<atomic<int>> nextSlot(design.numOfCells);
+    runOnThreads(threads, [&](int t) {
+        for (int c = (long long)design.numOfCells * t / threads; c < (long long)design.numOfCells * (t + 1) / threads; c++) {
+            nextSlot[c].store(0, memory_order_relaxed);
+        }
+    });
+    runOnThreads(threads, [&](int t) {
+        for (size_t i = design.netPins.size() * t / threads; i < design.netPins.size() * (t + 1) / threads; i++) {
+            nextSlot[design.netPins[i]].fetch_add(1, memory_order_relaxed);
+        }
+    });
+    for(int i = 0; i < design.numOfCells; i++) {
+        design.cellNetStart[i + 1] = design.cellNetStart[i] + nextSlot[i].load(memory_order_relaxed);
+        nextSlot[i].store(design.cellNetStart[i], memory_order_relaxed);
+    }
+    runOnThreads(threads, [&](int t) {
+        for(int netIndex = (long long)design.numOfNets * t / threads; netIndex < (long long)design.numOfNets * (t + 1) / threads; netIndex++) {
+            for(int i = design.netPinStart[netIndex]; i < design.netPinStart[netIndex + 1]; i++) {
+                design.cellNets[nextSlot[design.netPins[i]].fetch_add(1, memory_order_relaxed)] = netIndex;
+            }
+        }
+    });
+    runOnThreads(threads, [&](int t) {
+        for (int c = (long long)design.numOfCells * t / threads; c < (long long)design.numOfCells * (t + 1) / threads; c++) {
+            sort(design.cellNets.begin() + design.cellNetStart[c], design.cellNets.begin() + design.cellNetStart[c + 1]);
+        }
+    });
+}
+
+// parse threads for a file of the given size: one per 8 MB, at most one per core
+static int parseThreadsFor(size_t fileSize) {
+    int cores = max(1, (int)thread::hardware_concurrency());
+    return (int)max((size_t)1, min((size_t)cores, fileSize / (8 << 20)));
+}
+
+// parses a text netlist. Every line after the first is one net, so the net lines are cut into
+// newline-aligned chunks that threads parse into arrays of their own, then concatenated with a
+// prefix sum over the chunk sizes. threads = 0 picks a count from the file size.
+// Returns false after reporting the first malformed line.
+static bool parseTextNetList(netList &design, const mappedFile &netListFile, int threads) {
+    const char *begin = netListFile.data;
+    const char *end = begin + netListFile.size;
+    const char *firstLineEnd = endOfLine(begin, end);
+    if (!parseNetListFirstLine(design, begin, firstLineEnd)) {
+        return false;
+    }
+    if (threads == 0) {
+        threads = parseThreadsFor(netListFile.size);
+    }
+
+    // net lines follow the first newline; a newline ending the file does not start another one
+    const char *netLines = firstLineEnd < end ? firstLineEnd + 1 : end;
+    const char *netLinesEnd = netLines < end && end[-1] == '\n' ? end - 1 : end;
+    vector<netListChunk> chunks(threads);
+    const char *chunkBegin = netLines;
+    bool linesLeft = netLines < end;
+    for (int t = 0; t < threads; t++) {
+        netListChunk &chunk = chunks[t];
+        chunk.begin = chunk.end = chunkBegin;
+        chunk.numOfCells = design.numOfCells;
+        chunk.hasLines = linesLeft;
+        if (!linesLeft) {
+            continue;
+        }
+        const char *split = t == threads - 1 ? netLinesEnd : netLines + (netLinesEnd - netLines) * (t + 1) / threads;
+        chunk.end = endOfLine(max(split, chunkBegin), netLinesEnd);
+        linesLeft = chunk.end < netLinesEnd;
+        chunkBegin = linesLeft ? chunk.end + 1 : netLinesEnd;
+    }
+    runOnThreads(threads, [&](int t) {
+        parseNetListChunk(chunks[t]);
+    });
+
+    // report what a line-by-line parse would have stopped at first; a line past the
+    // declared number of nets is malformed
+    int netIndex = 0;
+    for (int t = 0; t < threads; t++) {
+        const netListChunk &chunk = chunks[t];
+        if (chunk.errorLine != -1 && netIndex + chunk.errorLine < design.numOfNets) {
+            if (chunk.errorCell != -1) {
+                cout << "Error: net line of netlist file refers to cell " << chunk.errorCell << " which does not exist" << endl;
+            } else {
+                cout << "Error: net line of netlist file is malformed" << endl;
+            }
+            return false;
+        }
+        netIndex += chunk.errorLine == -1 ? chunk.pinEnds.size() : chunk.errorLine + 1;
+        if (netIndex > design.numOfNets) {
+            cout << "Error: net line of netlist file is malformed" << endl;
+            return false;
+        }
+    }
+
+    vector<size_t> pinOffset(threads + 1, 0), netOffset(threads + 1, 0);
+    for (int t = 0; t < threads; t++) {
+        pinOffset[t + 1] = pinOffset[t] + chunks[t].pins.size();
+        netOffset[t + 1] = netOffset[t] + chunks[t].pinEnds.size();
+    }
+    design.netPinStart.resize(netOffset[threads] + 1);
+    if (threads == 1) {
+        design.netPins.swap(chunks[0].pins);
+    } else {
+        design.netPins.resize(pinOffset[threads]);
+    }
+    runOnThreads(threads, [&](int t) {
+        if (threads > 1) {
+            copy(chunks[t].pins.begin(), chunks[t].pins.end(), design.netPins.begin() + pinOffset[t]);
+        }
+        for (int i = 0; i < chunks[t].pinEnds.size(); i++) {
+            design.netPinStart[netOffset[t] + i + 1] = pinOffset[t] + chunks[t].pinEnds[i];
+        }
+    });
+    buildCellNets(design, threads);
+    return true;
+}
+
+// header of the binary netlist format. The CSR arrays netPinStart, netPins, cellNetStart and
+// cellNets follow it as 32-bit integers in native byte order, so loading is a copy, not a parse.
+struct binaryNetListHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t numOfCells, numOfNets, numOfRows, numOfColumns;
+    uint64_t numOfPins;
+    // size and modification time of the text netlist a cache was written for, 0 when converted
+    uint64_t sourceSize;
+    int64_t sourceModified;
+};
+
+const char binaryNetListMagic[8] = {'S', 'A', 'N', 'E', 'T', 'B', 'I', 'N'};
+
+const uint32_t binaryNetListVersion = 1;
+
+// text netlists at least this large are cached in binary form next to the file
+const size_t netListCacheMinimumSize = 1 << 20;
+
+static bool isBinaryNetList(const mappedFile &file) {
+    return file.size >= sizeof(binaryNetListMagic) && memcmp(file.data, binaryNetListMagic, sizeof(binaryNetListMagic)) == 0;
+}
+
+// size and modification time in nanoseconds of a file, the key of its cache
+static bool sourceStampOf(const string &fileName, uint64_t &size, int64_t &modified) {
+    struct stat status;
+    if (stat(fileName.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) {
+        return false; // only regular files have a size and time that identify their contents
+    }
+    size = status.st_size;
+    modified = (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+    return true;
+}
+
+// an index array is a CSR offset array: it starts at 0, never decreases and ends at total
+static bool isOffsetArray(const int32_t *offsets, int64_t count, uint64_t total) {
+    if (offsets[0] != 0 || offsets[count - 1] != (int64_t)total) {
+        return false;
+    }
+    for (int64_t i = 1; i < count; i++) {
+        if (offsets[i] < offsets[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isIndexArray(const int32_t *indices, uint64_t count, int32_t limit) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (indices[i] < 0 || indices[i] >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the text parser's guarantees the incremental box updates rely on: no net lists a cell twice and
+// the nets of every cell are cellNets exactly, in increasing order, as buildCellNets() makes them
+static bool isTransposedWithoutDuplicates(const int32_t *netPinStart, const int32_t *netPins, int32_t numOfNets,
+                                          const int32_t *cellNetStart, const int32_t *cellNets, int32_t numOfCells) {
+    vector<int32_t> nextSlot(cellNetStart, cellNetStart + numOfCells);
+    for (int32_t netIndex = 0; netIndex < numOfNets; netIndex++) {
+        for (int32_t i = netPinStart[netIndex]; i < netPinStart[netIndex + 1]; i++) {
+            int32_t cellIndex = netPins[i];
+            int32_t slot = nextSlot[cellIndex]++;
+            // a repeated pin finds its own net in the slot before
+            if (slot >= cellNetStart[cellIndex + 1] || cellNets[slot] != netIndex ||
+                (slot > cellNetStart[cellIndex] && cellNets[slot - 1] == netIndex)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// loads a binary netlist into design after checking that it is complete, every index is in
+// range and the two CSR arrays describe the same duplicate-free pins; when expectedSourceSize
+// is set the file must be a cache of that source.
+// Leaves design untouched and returns false otherwise.
+static bool loadBinaryNetList(netList &design, const mappedFile &file, const uint64_t *expectedSourceSize = nullptr, int64_t expectedSourceModified = 0) {
+    if (!isBinaryNetList(file) || file.size < sizeof(binaryNetListHeader)) {
+        return false;
+    }
+    binaryNetListHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    if (header.version != binaryNetListVersion || header.headerSize != sizeof(header) ||
+        header.numOfCells < 0 || header.numOfNets < 0 || header.numOfRows < 0 || header.numOfColumns < 0 ||
+        header.numOfPins > INT32_MAX) {
+        return false;
+    }
+    if (expectedSourceSize != nullptr && (header.sourceSize != *expectedSourceSize || header.sourceModified != expectedSourceModified)) {
+        return false;
+    }
+    uint64_t integers = (uint64_t)header.numOfNets + 1 + header.numOfPins + (uint64_t)header.numOfCells + 1 + header.numOfPins;
+    if (file.size != sizeof(header) + integers * sizeof(int32_t)) {
+        return false;
+    }
+    // the arrays start 4-byte aligned since the mapping is page aligned and the header is 56 bytes
+    const int32_t *fileNetPinStart = (const int32_t *)(file.data + sizeof(header));
+    const int32_t *fileNetPins = fileNetPinStart + header.numOfNets + 1;
+    const int32_t *fileCellNetStart = fileNetPins + header.numOfPins;
+    const int32_t *fileCellNets = fileCellNetStart + header.numOfCells + 1;
+    if (!isOffsetArray(fileNetPinStart, header.numOfNets + 1, header.numOfPins) ||
+        !isIndexArray(fileNetPins, header.numOfPins, header.numOfCells) ||
+        !isOffsetArray(fileCellNetStart, header.numOfCells + 1, header.numOfPins) ||
+        !isIndexArray(fileCellNets, header.numOfPins, header.numOfNets) ||
+        !isTransposedWithoutDuplicates(fileNetPinStart, fileNetPins, header.numOfNets, fileCellNetStart, fileCellNets, header.numOfCells)) {
+        return false;
+    }
+    design.numOfCells = header.numOfCells;
+    design.numOfNets = header.numOfNets;
+    design.numOfRows = header.numOfRows;
+    design.numOfColumns = header.numOfColumns;
+    design.netPinStart.assign(fileNetPinStart, fileNetPins);
+    design.netPins.assign(fileNetPins, fileCellNetStart);
+    design.cellNetStart.assign(fileCellNetStart, fileCellNets);
+    design.cellNets.assign(fileCellNets, fileCellNets + header.numOfPins);
+    return true;
+}
+
+bool writeBinaryNetList(const netList &design, const string &fileName, uint64_t sourceSize, int64_t sourceModified) {
+    binaryNetListHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, binaryNetListMagic, sizeof(header.magic));
+    header.version = binaryNetListVersion;
+    header.headerSize = sizeof(header);
+    header.numOfCells = design.numOfCells;
+    header.numOfNets = design.numOfNets;
+    header.numOfRows = design.numOfRows;
+    header.numOfColumns = design.numOfColumns;
+    header.numOfPins = design.netPins.size();
+    header.sourceSize = sourceSize;
+    header.sourceModified = sourceModified;
+
+    string temporaryFileName = fileName + ".tmp" + to_string(getpid());
+    ofstream binaryFile(temporaryFileName, ios::binary);
+    binaryFile.write((const char *)&header, sizeof(header));
+    const vector<int> *arrays[4] = { &design.netPinStart, &design.netPins, &design.cellNetStart, &design.cellNets };
+    for (int i = 0; i < 4; i++) {
+        binaryFile.write((const char *)arrays[i]->data(), arrays[i]->size() * sizeof(int));
+    }
+    binaryFile.close();
+    if (!binaryFile || rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+        remove(temporaryFileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool parseNetListFile(netList &design, string netListFileName, int threads, bool useCache) {
+    cout << "Parsing netlist file: " << netListFileName << endl;
+    mappedFile netListFile;
+    if (netListFile.open(netListFileName)) {
+        if (isBinaryNetList(netListFile)) {
+            if (!loadBinaryNetList(design, netListFile)) {
+                cout << "Error: binary netlist file is truncated, corrupt or of another version" << endl;
+                return false;
+            }
+            return true;
+        }
+        uint64_t sourceSize = 0;
+        int64_t sourceModified = 0;
+        string cacheFileName = netListFileName + ".cache";
+        bool cacheable = useCache && netListFile.size >= netListCacheMinimumSize && sourceStampOf(netListFileName, sourceSize, sourceModified);
+        if (cacheable) {
+            mappedFile cacheFile;
+            if (cacheFile.open(cacheFileName) && loadBinaryNetList(design, cacheFile, &sourceSize, sourceModified)) {
+                cout << "Loaded cached netlist: " << cacheFileName << endl;
+                return true;
+            }
+        }
+        if (!parseTextNetList(design, netListFile, threads)) {
+            return false;
+        }
+        if (cacheable) {
+            writeBinaryNetList(design, cacheFileName, sourceSize, sourceModified);
+        }
+        return true;
+    }
+    else 
+        cout << "Unable to open file" << endl;
+    return false;
+}
+
+void resetPlacement(placement &p, const netList &design) {
+    p.design = &design;
+    p.cellX.assign(design.numOfCells, -1);
+    p.cellY.assign(design.numOfCells, -1);
+    p.nets.assign(design.numOfNets, boundingBox());
+    p.grid.resize(design.numOfRows, design.numOfColumns, design.numOfCells);
+    p.totalWireLength = 0;
+    p.scratch.reset(design);
+}
+
+bool placeInitiallyRandom(placement &p, uint64_t seed) {
+    const netList &design = *p.design;
+    annealRng rng(deriveSeed(seed, PLACEMENT_STREAM));
+    if ((long long)design.numOfCells > (long long)design.numOfRows*design.numOfColumns) {
+        return false;
+    }
+    for(int i = 0; i < design.numOfCells; i++) {
+        // draw straight from the free sites instead of retrying occupied ones
+        uniform_int_distribution<int> dist(0, p.grid.freeSites.size()-1);
+        int random_number = p.grid.freeSites[dist(rng)];
+        // x is column number
+        // y is row number
+        p.cellY[i] = random_number / design.numOfColumns;
+        p.cellX[i] = random_number % design.numOfColumns;
+
+        // double checking
+        if (p.cellY[i] < design.numOfRows && p.cellX[i] < design.numOfColumns) {
+            p.grid.set(p.cellY[i], p.cellX[i], i);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// HPWL kernels. Each fills a box with its edge counts and returns the HPWL.
+
+// branch-free min/max and counting reductions, the scalar kernel of the dispatch below
+static int scalarNetBox(const int *pins, int degree, const int *cellX, const int *cellY, boundingBox &box) {
+    if (degree == 0) {
+        box.reset();
+        box.HPWL = 0; // net without pins
+        return 0;
+    }
+    int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+    for(int i = 0; i < degree; i++) {
+        int x = cellX[pins[i]], y = cellY[pins[i]];
+        minX = min(minX, x);
+        maxX = max(maxX, x);
+        minY = min(minY, y);
+        maxY = max(maxY, y);
+    }
+    int minXCount = 0, maxXCount = 0, minYCount = 0, maxYCount = 0;
+    for(int i = 0; i < degree; i++) {
+        int x = cellX[pins[i]], y = cellY[pins[i]];
+        minXCount += x == minX;
+        maxXCount += x == maxX;
+        minYCount += y == minY;
+        maxYCount += y == maxY;
+    }
+    box.minX = minX;
+    box.maxX = maxX;
+    box.minY = minY;
+    box.maxY = maxY;
+    box.minXCount = minXCount;
+    box.maxXCount = maxXCount;
+    box.minYCount = minYCount;
+    box.maxYCount = maxYCount;
+    box.HPWL = (maxX - minX) + (maxY - minY);
+    return box.HPWL;
+}
+
+typedef int (*netBoxKernel)(const int *pins, int degree, const int *cellX, const int *cellY, boundingBox &box);
+
+// a 2-pin net in closed form: each edge holds one pin, or both when the pins line up
+static int twoPinNetBox(const int *pins, const int *cellX, const int *cellY, boundingBox &box) {
+    int x0 = cellX[pins[0]], x1 = cellX[pins[1]];
+    int y0 = cellY[pins[0]], y1 = cellY[pins[1]];
+    box.minX = min(x0, x1);
+    box.maxX = max(x0, x1);
+    box.minY = min(y0, y1);
+    box.maxY = max(y0, y1);
+    box.minXCount = box.maxXCount = 1 + (x0 == x1);
+    box.minYCount = box.maxYCount = 1 + (y0 == y1);
+    box.HPWL = (box.maxX - box.minX) + (box.maxY - box.minY);
+    return box.HPWL;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// SIMD versions of scalarNetBox(), one pin per lane. Every lane keeps its own edges and how many of
+// its pins sit on them, so each coordinate is gathered once, and the lanes are merged at the end.
+
+// a lane's minimum edge and count after one more coordinate x
+__attribute__((target("avx2")))
+static inline void minEdgeAVX2(__m256i x, __m256i &edge, __m256i &count) {
+    __m256i below = _mm256_cmpgt_epi32(edge, x);
+    __m256i on = _mm256_cmpeq_epi32(edge, x);
+    count = _mm256_sub_epi32(count, on);
+    count = _mm256_blendv_epi8(count, _mm256_set1_epi32(1), below);
+    edge = _mm256_min_epi32(edge, x);
+}
+
+__attribute__((target("avx2")))
+static inline void maxEdgeAVX2(__m256i x, __m256i &edge, __m256i &count) {
+    __m256i above = _mm256_cmpgt_epi32(x, edge);
+    __m256i on = _mm256_cmpeq_epi32(edge, x);
+    count = _mm256_sub_epi32(count, on);
+    count = _mm256_blendv_epi8(count, _mm256_set1_epi32(1), above);
+    edge = _mm256_max_epi32(edge, x);
+}
+
+// combines the edge and count of every lane with those of another lane
+template <bool minimum>
+__attribute__((target("avx2")))
+static inline void combineLanesAVX2(__m256i &edge, __m256i &count, __m256i otherEdge, __m256i otherCount) {
+    __m256i combined = minimum ? _mm256_min_epi32(edge, otherEdge) : _mm256_max_epi32(edge, otherEdge);
+    count = _mm256_add_epi32(_mm256_and_si256(count, _mm256_cmpeq_epi32(edge, combined)),
+                             _mm256_and_si256(otherCount, _mm256_cmpeq_epi32(otherEdge, combined)));
+    edge = combined;
+}
+
+// merges the lanes of an edge in three combining steps: the overall edge and the summed counts of
+// the lanes holding it
+template <bool minimum>
+__attribute__((target("avx2")))
+static inline void mergeLanesAVX2(__m256i edge, __m256i count, int &value, int &total) {
+    combineLanesAVX2<minimum>(edge, count, _mm256_permute2x128_si256(edge, edge, 1), _mm256_permute2x128_si256(count, count, 1));
+    combineLanesAVX2<minimum>(edge, count, _mm256_shuffle_epi32(edge, _MM_SHUFFLE(1, 0, 3, 2)), _mm256_shuffle_epi32(count, _MM_SHUFFLE(1, 0, 3, 2)));
+    combineLanesAVX2<minimum>(edge, count, _mm256_shuffle_epi32(edge, _MM_SHUFFLE(2, 3, 0, 1)), _mm256_shuffle_epi32(count, _MM_SHUFFLE(2, 3, 0, 1)));
+    value = _mm256_cvtsi256_si32(edge);
+    total = _mm256_cvtsi256_si32(count);
+}
+
+__attribute__((target("avx2")))
+static int avx2NetBox(const int *pins, int degree, const int *cellX, const int *cellY, boundingBox &box) {
+    if (degree < 8) {
+        return scalarNetBox(pins, degree, cellX, cellY, box);
+    }
+    __m256i minX = _mm256_set1_epi32(INT_MAX), maxX = _mm256_set1_epi32(INT_MIN);
+    __m256i minY = minX, maxY = maxX;
+    __m256i minXCount = _mm256_setzero_si256(), maxXCount = minXCount, minYCount = minXCount, maxYCount = minXCount;
+    int i = 0;
+    for(; i + 8 <= degree; i += 8) {
+        __m256i cells = _mm256_loadu_si256((const __m256i *)(pins + i));
+        __m256i x = _mm256_i32gather_epi32(cellX, cells, 4);
+        __m256i y = _mm256_i32gather_epi32(cellY, cells, 4);
+        minEdgeAVX2(x, minX, minXCount);
+        maxEdgeAVX2(x, maxX, maxXCount);
+        minEdgeAVX2(y, minY, minYCount);
+        maxEdgeAVX2(y, maxY, maxYCount);
+    }
+    if (i < degree) {
+        // last partial vector: missing lanes read INT_MAX for the minimum and INT_MIN for the
+        // maximum, which only ever lands on lanes the merge ignores
+        __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(degree - i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i cells = _mm256_maskload_epi32(pins + i, valid);
+        __m256i x = _mm256_mask_i32gather_epi32(_mm256_set1_epi32(INT_MAX), cellX, cells, valid, 4);
+        __m256i y = _mm256_mask_i32gather_epi32(_mm256_set1_epi32(INT_MAX), cellY, cells, valid, 4);
+        minEdgeAVX2(x, minX, minXCount);
+        maxEdgeAVX2(_mm256_blendv_epi8(_mm256_set1_epi32(INT_MIN), x, valid), maxX, maxXCount);
+        minEdgeAVX2(y, minY, minYCount);
+        maxEdgeAVX2(_mm256_blendv_epi8(_mm256_set1_epi32(INT_MIN), y, valid), maxY, maxYCount);
+    }
+    mergeLanesAVX2<true>(minX, minXCount, box.minX, box.minXCount);
+    mergeLanesAVX2<false>(maxX, maxXCount, box.maxX, box.maxXCount);
+    mergeLanesAVX2<true>(minY, minYCount, box.minY, box.minYCount);
+    mergeLanesAVX2<false>(maxY, maxYCount, box.maxY, box.maxYCount);
+    box.HPWL = (box.maxX - box.minX) + (box.maxY - box.minY);
+    return box.HPWL;
+}
+
+// the all-lanes masked min/max and gather keep GCC from warning about undefined source lanes
+__attribute__((target("avx512f")))
+static inline void minEdgeAVX512(__m512i x, __m512i &edge, __m512i &count) {
+    __mmask16 below = _mm512_cmplt_epi32_mask(x, edge);
+    __mmask16 on = _mm512_cmpeq_epi32_mask(x, edge);
+    count = _mm512_mask_add_epi32(count, on, count, _mm512_set1_epi32(1));
+    count = _mm512_mask_mov_epi32(count, below, _mm512_set1_epi32(1));
+    edge = _mm512_mask_min_epi32(edge, 0xFFFF, edge, x);
+}
+
+__attribute__((target("avx512f")))
+static inline void maxEdgeAVX512(__m512i x, __m512i &edge, __m512i &count) {
+    __mmask16 above = _mm512_cmpgt_epi32_mask(x, edge);
+    __mmask16 on = _mm512_cmpeq_epi32_mask(x, edge);
+    count = _mm512_mask_add_epi32(count, on, count, _mm512_set1_epi32(1));
+    count = _mm512_mask_mov_epi32(count, above, _mm512_set1_epi32(1));
+    edge = _mm512_mask_max_epi32(edge, 0xFFFF, edge, x);
+}
+
+// folds the upper half of the lanes onto the lower half, then merges those like mergeLanesAVX2()
+template <bool minimum>
+__attribute__((target("avx512f")))
+static inline void mergeLanesAVX512(__m512i edge, __m512i count, int &value, int &total) {
+    __m256i lowEdge = _mm512_mask_extracti64x4_epi64(_mm256_setzero_si256(), 0xF, edge, 0);
+    __m256i lowCount = _mm512_mask_extracti64x4_epi64(_mm256_setzero_si256(), 0xF, count, 0);
+    combineLanesAVX2<minimum>(lowEdge, lowCount, _mm512_mask_extracti64x4_epi64(_mm256_setzero_si256(), 0xF, edge, 1),
+                              _mm512_mask_extracti64x4_epi64(_mm256_setzero_si256(), 0xF, count, 1));
+    mergeLanesAVX2<minimum>(lowEdge, lowCount, value, total);
+}
+
+__attribute__((target("avx512f")))
+static int avx512NetBox(const int *pins, int degree, const int *cellX, const int *cellY, boundingBox &box) {
+    if (degree < 128) {
+        // gathers dominate below this degree and the wider merge does not pay off
+        return avx2NetBox(pins, degree, cellX, cellY, box);
+    }
+    __m512i minX = _mm512_set1_epi32(INT_MAX), maxX = _mm512_set1_epi32(INT_MIN);
+    __m512i minY = minX, maxY = maxX;
+    __m512i minXCount = _mm512_setzero_si512(), maxXCount = minXCount, minYCount = minXCount, maxYCount = minXCount;
+    int i = 0;
+    for(; i + 16 <= degree; i += 16) {
+        __m512i cells = _mm512_loadu_si512((const void *)(pins + i));
+        __m512i x = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, cells, cellX, 4);
+        __m512i y = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, cells, cellY, 4);
+        minEdgeAVX512(x, minX, minXCount);
+        maxEdgeAVX512(x, maxX, maxXCount);
+        minEdgeAVX512(y, minY, minYCount);
+        maxEdgeAVX512(y, maxY, maxYCount);
+    }
+    if (i < degree) {
+        // last partial vector, filled like the one of avx2NetBox()
+        __mmask16 valid = (__mmask16)((1u << (degree - i)) - 1);
+        __m512i cells = _mm512_maskz_loadu_epi32(valid, pins + i);
+        __m512i x = _mm512_mask_i32gather_epi32(_mm512_set1_epi32(INT_MAX), valid, cells, cellX, 4);
+        __m512i y = _mm512_mask_i32gather_epi32(_mm512_set1_epi32(INT_MAX), valid, cells, cellY, 4);
+        minEdgeAVX512(x, minX, minXCount);
+        maxEdgeAVX512(_mm512_mask_mov_epi32(_mm512_set1_epi32(INT_MIN), valid, x), maxX, maxXCount);
+        minEdgeAVX512(y, minY, minYCount);
+        maxEdgeAVX512(_mm512_mask_mov_epi32(_mm512_set1_epi32(INT_MIN), valid, y), maxY, maxYCount);
+    }
+    mergeLanesAVX512<true>(minX, minXCount, box.minX, box.minXCount);
+    mergeLanesAVX512<false>(maxX, maxXCount, box.maxX, box.maxXCount);
+    mergeLanesAVX512<true>(minY, minYCount, box.minY, box.minYCount);
+    mergeLanesAVX512<false>(maxY, maxYCount, box.maxY, box.maxYCount);
+    box.HPWL = (box.maxX - box.minX) + (box.maxY - box.minY);
+    return box.HPWL;
+}
+#endif
+
+bool hpwlKernelSupported(hpwlKernel kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (kernel == AVX2_HPWL) {
+        return __builtin_cpu_supports("avx2");
+    } else if (kernel == AVX512_HPWL) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2");
+    }
+#endif
+    return kernel == SCALAR_HPWL;
+}
+
+// AVX2 even where AVX-512 is available: the wider kernel never measured faster on the test
+// netlists and was slower on some AVX-512 machines, so it is only run when asked for by name
+hpwlKernel detectHPWLKernel() {
+    if (hpwlKernelSupported(AVX2_HPWL)) {
+        return AVX2_HPWL;
+    }
+    return SCALAR_HPWL;
+}
+
+const char *hpwlKernelName(hpwlKernel kernel) {
+    if (kernel == AVX2_HPWL) {
+        return "avx2";
+    } else if (kernel == AVX512_HPWL) {
+        return "avx512";
+    }
+    return "scalar";
+}
+
+static netBoxKernel netBoxKernelFor(hpwlKernel kernel) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (kernel == AVX2_HPWL) {
+        return avx2NetBox;
+    } else if (kernel == AVX512_HPWL) {
+        return avx512NetBox;
+    }
+#endif
+    return scalarNetBox;
+}
+
+// the kernel of this processor, picked on first use
+static netBoxKernel defaultNetBoxKernel() {
+    static const netBoxKernel kernel = netBoxKernelFor(detectHPWLKernel());
+    return kernel;
+}
+
+int computeHPWLofNet(placement &p, int netIndex) {
+    const netList &design = *p.design;
+    const int *pins = design.netPins.data() + design.netPinStart[netIndex];
+    int degree = design.netPinStart[netIndex + 1] - design.netPinStart[netIndex];
+    if (degree == 2) {
+        return twoPinNetBox(pins, p.cellX.data(), p.cellY.data(), p.nets[netIndex]);
+    }
+    return defaultNetBoxKernel()(pins, degree, p.cellX.data(), p.cellY.data(), p.nets[netIndex]);
+}
+
+int computeHPWLofNets(placement &p, const vector<int> &nets, hpwlKernel kernel) {
+    const netList &design = *p.design;
+    netBoxKernel netBox = netBoxKernelFor(kernel);
+    const int *pins = design.netPins.data();
+    const int *netPinStart = design.netPinStart.data();
+    int totalWireLength = 0;
+    for(int netIndex : nets) {
+        totalWireLength += netBox(pins + netPinStart[netIndex], netPinStart[netIndex + 1] - netPinStart[netIndex], p.cellX.data(), p.cellY.data(), p.nets[netIndex]);
+    }
+    return totalWireLength;
+}
+
+void computeHPWLofAllNets(placement &p) {
+    const netList &design = *p.design;
+    p.totalWireLength = 0;
+    for(int i = 0; i < design.numOfNets; i++) {
+        p.totalWireLength += computeHPWLofNet(p, i);
+    }
+}
+
+int computeTotalWireLength(const placement &p) {
+    const netList &design = *p.design;
+    int totalWireLength = 0;
+    for(int i = 0; i < design.numOfNets; i++) {
+        totalWireLength += p.nets[i].HPWL;
+    }
+    return totalWireLength;
+}
+
+// How the move helpers read and write the shared state of a placement. The sequential annealers
+// use plain accesses. The lock-free annealer reads cell positions, sites and net boxes that other
+// threads write at the same time, so it goes through relaxed atomics: every value it reads was
+// written whole, though possibly stale, and no ordering is implied beyond the site claims.
+struct plainAccess {
+    template <class T> static T load(const T &value) { return value; }
+    template <class T> static void store(T &target, T value) { target = value; }
+};
+
+struct relaxedAccess {
+    template <class T> static T load(const T &value) { return __atomic_load_n(&value, __ATOMIC_RELAXED); }
+    template <class T> static void store(T &target, T value) { __atomic_store_n(&target, value, __ATOMIC_RELAXED); }
+};
+
+template <class access>
+static int occupantOf(const placementGrid &grid, int site) {
+    return grid.narrow ? (int)access::load(grid.narrowSites[site]) - 1 : (int)access::load(grid.wideSites[site]) - 1;
+}
+
+template <class access>
+static void storeOccupant(placementGrid &grid, int site, int cellIndex) {
+    if (grid.narrow) {
+        access::store(grid.narrowSites[site], (uint16_t)(cellIndex + 1));
+    } else {
+        access::store(grid.wideSites[site], (uint32_t)(cellIndex + 1));
+    }
+}
+
+// field by field, so a box another thread is writing may mix its old and new edges
+template <class access>
+static void copyBox(boundingBox &target, const boundingBox &box) {
+    access::store(target.minX, access::load(box.minX));
+    access::store(target.minY, access::load(box.minY));
+    access::store(target.maxX, access::load(box.maxX));
+    access::store(target.maxY, access::load(box.maxY));
+    access::store(target.minXCount, access::load(box.minXCount));
+    access::store(target.minYCount, access::load(box.minYCount));
+    access::store(target.maxXCount, access::load(box.maxXCount));
+    access::store(target.maxYCount, access::load(box.maxYCount));
+    access::store(target.HPWL, access::load(box.HPWL));
+}
+
+template <class access>
+static swapMove proposeMoveWith(const placement &p, annealRng &rng, int rangeLimit) {
+    const netList &design = *p.design;
+    swapMove candidate;
+    candidate.deltaHPWL = 0;
+    int numOfTargets = design.numOfCells - 1 + (int)p.grid.freeSites.size();
+    if (design.numOfCells == 0 || numOfTargets == 0) {
+        // nothing can move
+        candidate.cell1Index = candidate.cell2Index = -1;
+        return candidate;
+    }
+    candidate.cell1Index = randomBelow(rng, design.numOfCells);
+    candidate.cell1Row = access::load(p.cellY[candidate.cell1Index]);
+    candidate.cell1Column = access::load(p.cellX[candidate.cell1Index]);
+
+    if (rangeLimit < max(design.numOfRows, design.numOfColumns) - 1) {
+        int lowRow = max(0, candidate.cell1Row - rangeLimit), highRow = min(design.numOfRows - 1, candidate.cell1Row + rangeLimit);
+        int lowColumn = max(0, candidate.cell1Column - rangeLimit), highColumn = min(design.numOfColumns - 1, candidate.cell1Column + rangeLimit);
+        do {
+            candidate.cell2Row = randomBetween(rng, lowRow, highRow);
+            candidate.cell2Column = randomBetween(rng, lowColumn, highColumn);
+        } while (candidate.cell2Row == candidate.cell1Row && candidate.cell2Column == candidate.cell1Column);
+        candidate.cell2Index = occupantOf<access>(p.grid, candidate.cell2Row * design.numOfColumns + candidate.cell2Column);
+        return candidate;
+    }
+
+    int target = randomBelow(rng, numOfTargets);
+    if (target < design.numOfCells - 1) {
+        // skip over cell1 itself
+        candidate.cell2Index = target < candidate.cell1Index ? target : target + 1;
+        candidate.cell2Row = access::load(p.cellY[candidate.cell2Index]);
+        candidate.cell2Column = access::load(p.cellX[candidate.cell2Index]);
+    } else {
+        int site = p.grid.freeSites[target - (design.numOfCells - 1)];
+        candidate.cell2Index = -1;
+        candidate.cell2Row = site / design.numOfColumns;
+        candidate.cell2Column = site % design.numOfColumns;
+    }
+    return candidate;
+}
+
+swapMove proposeMove(const placement &p, annealRng &rng, int rangeLimit) {
+    return proposeMoveWith<plainAccess>(p, rng, rangeLimit);
+}
+
+int updateRangeLimit(const netList &design, int rangeLimit, double acceptanceRate) {
+    double newRangeLimit = rangeLimit * (1.0 - 0.44 + acceptanceRate);
+    int maxRangeLimit = max(design.numOfRows, design.numOfColumns) - 1;
+    return max(1, min(maxRangeLimit, (int)newRangeLimit));
+}
+
+// full rescan of a net with the moved cells at their candidate positions
+template <class access>
+static void rescanCandidateNet(const placement &p, const swapMove &candidate, candidateNet &box) {
+    const netList &design = *p.design;
+    box.reset();
+    for(int i = design.netPinStart[box.netIndex]; i < design.netPinStart[box.netIndex + 1]; i++) {
+        int cellIndex = design.netPins[i];
+        if (cellIndex == candidate.cell1Index) {
+            box.addPin(candidate.cell2Column, candidate.cell2Row);
+        } else if (cellIndex == candidate.cell2Index) {
+            box.addPin(candidate.cell1Column, candidate.cell1Row);
+        } else {
+            box.addPin(access::load(p.cellX[cellIndex]), access::load(p.cellY[cellIndex]));
+        }
+    }
+    box.HPWL = (box.maxX - box.minX) + (box.maxY - box.minY);
+}
+
+template <class access>
+static void addCandidateNet(const placement &p, moveScratch &scratch, swapMove &candidate, int netIndex, bool movesCell1, bool movesCell2) {
+    candidateNet box;
+    copyBox<access>(box, p.nets[netIndex]);
+    box.netIndex = netIndex;
+    int oldHPWL = box.HPWL;
+    bool valid = true;
+    if (movesCell1) {
+        valid = box.movePin(candidate.cell1Column, candidate.cell1Row, candidate.cell2Column, candidate.cell2Row);
+    }
+    if (valid && movesCell2) {
+        valid = box.movePin(candidate.cell2Column, candidate.cell2Row, candidate.cell1Column, candidate.cell1Row);
+    }
+    if (!valid) {
+        rescanCandidateNet<access>(p, candidate, box);
+    }
+    scratch.candidateNets.push_back(box);
+    candidate.deltaHPWL += box.HPWL - oldHPWL;
+}
+
+template <class access>
+static int evaluateMoveWith(const placement &p, moveScratch &scratch, swapMove &candidate) {
+    const netList &design = *p.design;
+    scratch.candidateNets.clear();
+    candidate.deltaHPWL = 0;
+    if (candidate.cell1Index == -1) {
+        // both positions are empty, nothing to move
+        return 0;
+    }
+    scratch.nextMove();
+    int cell1 = candidate.cell1Index;
+    int cell2 = candidate.cell2Index;
+    if (cell2 != -1) {
+        for(int i = design.cellNetStart[cell2]; i < design.cellNetStart[cell2 + 1]; i++) {
+            scratch.netCell2Stamp[design.cellNets[i]] = scratch.moveStamp;
+        }
+    }
+    for(int i = design.cellNetStart[cell1]; i < design.cellNetStart[cell1 + 1]; i++) {
+        int netIndex = design.cellNets[i];
+        scratch.netMoveStamp[netIndex] = scratch.moveStamp;
+        addCandidateNet<access>(p, scratch, candidate, netIndex, true, scratch.netCell2Stamp[netIndex] == scratch.moveStamp);
+    }
+    if (cell2 != -1) {
+        for(int i = design.cellNetStart[cell2]; i < design.cellNetStart[cell2 + 1]; i++) {
+            int netIndex = design.cellNets[i];
+            if (scratch.netMoveStamp[netIndex] != scratch.moveStamp) {
+                addCandidateNet<access>(p, scratch, candidate, netIndex, false, true);
+            }
+        }
+    }
+    return candidate.deltaHPWL;
+}
+
+int evaluateMove(const placement &p, moveScratch &scratch, swapMove &candidate) {
+    return evaluateMoveWith<plainAccess>(p, scratch, candidate);
+}
+
+int evaluateMove(placement &p, swapMove &candidate) {
+    return evaluateMove(p, p.scratch, candidate);
+}
+
+void commitMove(placement &p, const vector<candidateNet> &candidateNets, const swapMove &candidate) {
+    if (candidate.cell1Index == -1) {
+        return;
+    }
+    p.cellX[candidate.cell1Index] = candidate.cell2Column;
+    p.cellY[candidate.cell1Index] = candidate.cell2Row;
+    p.grid.set(candidate.cell2Row, candidate.cell2Column, candidate.cell1Index);
+    if (candidate.cell2Index != -1) {
+        p.cellX[candidate.cell2Index] = candidate.cell1Column;
+        p.cellY[candidate.cell2Index] = candidate.cell1Row;
+    }
+    p.grid.set(candidate.cell1Row, candidate.cell1Column, candidate.cell2Index);
+    for(int i = 0; i < candidateNets.size(); i++) {
+        const candidateNet &box = candidateNets[i];
+        static_cast<boundingBox &>(p.nets[box.netIndex]) = box;
+    }
+    p.totalWireLength += candidate.deltaHPWL;
+}
+
+void commitMove(placement &p, const swapMove &candidate) {
+    commitMove(p, p.scratch.candidateNets, candidate);
+}
+
+bool detectTwoEmptyCells(const placement &p) {
+    const netList &design = *p.design;
+    int emptyCellCount = 0;
+    for(int i = 0; i < design.numOfRows; i++) {
+        for(int j = 0; j < design.numOfColumns; j++) {
+            if(p.grid.at(i, j) == -1) {
+                emptyCellCount++;
+                if(emptyCellCount == 2) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+temperatureRange legacyTemperatureRange(const netList &design, int initialCost) {
+    temperatureRange range;
+    range.initialTemperature = 500*initialCost;
+    range.finalTemperature = 0.000005*initialCost/design.numOfNets;
+    return range;
+}
+
+temperatureRange calibrateTemperatureRange(placement &p, int samples, uint64_t seed) {
+    const netList &design = *p.design;
+    annealRng rng(deriveSeed(seed, CALIBRATION_STREAM));
+    int rangeLimit = max(design.numOfRows, design.numOfColumns) - 1;
+    double sum = 0, sumOfSquares = 0;
+    int smallestDelta = INT_MAX;
+    for(int i = 0; i < samples; i++) {
+        swapMove candidate = proposeMove(p, rng, rangeLimit);
+        int deltaHPWL = evaluateMove(p, candidate);
+        sum += deltaHPWL;
+        sumOfSquares += (double)deltaHPWL * deltaHPWL;
+        if (deltaHPWL != 0) {
+            smallestDelta = min(smallestDelta, abs(deltaHPWL));
+        }
+    }
+    double mean = sum / samples;
+    double standardDeviation = sqrt(max(0.0, sumOfSquares / samples - mean * mean));
+    if (samples == 0 || smallestDelta == INT_MAX || standardDeviation == 0) {
+        return legacyTemperatureRange(*p.design, p.totalWireLength);
+    }
+    temperatureRange range;
+    range.initialTemperature = 20 * standardDeviation;
+    range.finalTemperature = smallestDelta / log(1000.0);
+    return range;
+}
+
+int geometricSteps(temperatureRange range, double coolingRate) {
+    if (range.initialTemperature <= range.finalTemperature) {
+        return 0;
+    }
+    return (int)ceil(log(range.finalTemperature / range.initialTemperature) / log(coolingRate));
+}
+
+int annealMoves(placement &p, double temperature, int moves, int rangeLimit, annealRng &rng, traceRecorder *trace) {
+    rangeLimitedMoves generator;
+    generator.rangeLimit = rangeLimit;
+    incrementalHPWL cost;
+    if (trace == nullptr) {
+        noTrace recorder;
+        return annealMovesWith(p, temperature, moves, generator, cost, recorder, rng);
+    }
+    recordTrace recorder{trace};
+    return annealMovesWith(p, temperature, moves, generator, cost, recorder, rng);
+}
+
+// the sequential and the speculative stepper of a schedule and recorder
+template <class schedulePolicy, class recorder>
+static int annealStepped(placement &p, temperatureRange range, uint64_t seed, schedulePolicy schedule, recorder trace,
+                         speculativeAnnealer *speculation) {
+    if (speculation == nullptr) {
+        return annealWith(p, range, seed, rangeLimitedMoves(), incrementalHPWL(), schedule, trace);
+    }
+    return annealWith(p, range, seed, rangeLimitedMoves(), incrementalHPWL(), schedule, trace, speculativeSteps{speculation});
+}
+
+// the fast and the instrumented variant of a schedule
+template <class schedulePolicy>
+static int annealScheduled(placement &p, temperatureRange range, uint64_t seed, schedulePolicy schedule,
+                           speculativeAnnealer *speculation, traceRecorder *trace) {
+    if (trace == nullptr) {
+        return annealStepped(p, range, seed, schedule, noTrace(), speculation);
+    }
+    return annealStepped(p, range, seed, schedule, recordTrace{trace}, speculation);
+}
+
+int simulateAnnealingFast(placement &p, temperatureRange range, coolingSchedule schedule, uint64_t seed,
+                          speculativeAnnealer *speculation, traceRecorder *trace) {
+    return simulateAnnealing(p, range, 0.95, schedule, seed, speculation, trace);
+}
+
+int simulateAnnealing(placement &p, temperatureRange range, double coolingRate, coolingSchedule schedule, uint64_t seed,
+                      speculativeAnnealer *speculation, traceRecorder *trace) {
+    if (schedule == ADAPTIVE_COOLING) {
+        return annealScheduled(p, range, seed, adaptiveSchedule(), speculation, trace);
+    }
+    return annealScheduled(p, range, seed, geometricSchedule{coolingRate}, speculation, trace);
+}
+
+vector<sweepResult> runCoolingRateSweep(const placement &initial, const vector<double> &coolingRates, int runs, int threads, uint64_t seed) {
+    vector<sweepResult> results(coolingRates.size() * runs);
+    atomic<int> nextJob(0);
+    auto worker = [&]() {
+        placement p;
+        for (int job = nextJob++; job < results.size(); job = nextJob++) {
+            sweepResult &result = results[job];
+            result.coolingRate = coolingRates[job / runs];
+            result.run = job % runs;
+            uint64_t runSeed = deriveSeed(seed, SWEEP_STREAM, result.run);
+            ostringstream stepRows;
+            traceRecorder trace(&stepRows, runSeed);
+            ostringstream rowPrefix;
+            rowPrefix << result.coolingRate << "," << result.run << ",";
+            trace.rowPrefix = rowPrefix.str();
+            p = initial;
+            simulateAnnealing(p, legacyTemperatureRange(*p.design, p.totalWireLength), result.coolingRate, GEOMETRIC_COOLING, runSeed, nullptr, &trace);
+            result.finalWireLength = p.totalWireLength;
+            result.stepRows = stepRows.str();
+        }
+    };
+    vector<thread> pool;
+    for (int i = 0; i < min(threads, (int)results.size()); i++) {
+        pool.emplace_back(worker);
+    }
+    for (int i = 0; i < pool.size(); i++) {
+        pool[i].join();
+    }
+    return results;
+}
+
+// layout of one sweep of the domain-decomposed annealer, read-only while the sweep runs.
+// The grid is cut into stripes of rows or columns, alternating every sweep, and the stripes are
+// shifted by half a stripe every other pair of sweeps so cells near a boundary can cross it.
+struct regionSweep {
+    int regions;
+    bool columnStripes;
+    int extent, stripe, offset;
+    vector<int> regionOfCell;  // region of every cell at the start of the sweep
+    vector<int> regionOfNet;   // region holding every pin of the net, -1 for boundary-crossing nets
+    vector<int> snapshotX, snapshotY;
+
+    int regionOf(int row, int column) const {
+        int coordinate = columnStripes ? column : row;
+        return min(regions - 1, ((coordinate + offset) % extent) / stripe);
+    }
+
+    // contiguous run of rows (or columns) of the region containing coordinate; a shifted region
+    // wraps around the grid edge and is made of two such runs
+    void regionBounds(int coordinate, int &low, int &high) const {
+        int region = min(regions - 1, ((coordinate + offset) % extent) / stripe);
+        low = region * stripe - offset;
+        // the stripes round up, so the last region holding rows can end short of its full stripe
+        high = min(extent, (region + 1) * stripe) - offset - 1;
+        if (low < 0 && coordinate > high) {
+            low += extent;
+            high = extent - 1;
+        } else if (low < 0) {
+            low = 0;
+        }
+    }
+};
+
+// per-thread state of the domain-decomposed annealer
+struct regionWorker {
+    int region;
+    vector<int> cells; // cells inside the region at the start of the sweep
+    moveScratch scratch;
+    // HPWL of boundary-crossing nets as seen by this thread (own moves applied, other regions
+    // at their snapshot), valid when localStamp matches the sweep
+    vector<int> localHPWL, localStamp;
+    annealRng rng;
+    int acceptedMoves;
+};
+
+static void prepareRegionSweep(const placement &p, regionSweep &sweep, int sweepIndex) {
+    const netList &design = *p.design;
+    sweep.columnStripes = sweepIndex % 2 == 1;
+    sweep.extent = sweep.columnStripes ? design.numOfColumns : design.numOfRows;
+    sweep.stripe = max(1, (sweep.extent + sweep.regions - 1) / sweep.regions);
+    sweep.offset = (sweepIndex / 2) % 2 == 1 ? sweep.stripe / 2 : 0;
+    sweep.snapshotX = p.cellX;
+    sweep.snapshotY = p.cellY;
+    sweep.regionOfCell.resize(design.numOfCells);
+    for (int c = 0; c < design.numOfCells; c++) {
+        sweep.regionOfCell[c] = sweep.regionOf(p.cellY[c], p.cellX[c]);
+    }
+    sweep.regionOfNet.resize(design.numOfNets);
+    for (int n = 0; n < design.numOfNets; n++) {
+        int region = design.netPinStart[n] == design.netPinStart[n + 1] ? -1 : sweep.regionOfCell[design.netPins[design.netPinStart[n]]];
+        for (int i = design.netPinStart[n] + 1; i < design.netPinStart[n + 1] && region != -1; i++) {
+            if (sweep.regionOfCell[design.netPins[i]] != region) {
+                region = -1;
+            }
+        }
+        sweep.regionOfNet[n] = region;
+    }
+}
+
+// evaluates one net of a region move; nets inside the region are updated incrementally from their
+// shared box, which no other thread touches, boundary-crossing nets are rescanned with cells of
+// other regions at their snapshot position
+static void addRegionCandidateNet(const placement &p, const regionSweep &sweep, regionWorker &worker, int sweepIndex,
+                           swapMove &candidate, int netIndex, bool movesCell1, bool movesCell2) {
+    const netList &design = *p.design;
+    candidateNet box;
+    box.netIndex = netIndex;
+    int oldHPWL;
+    bool valid = false;
+    if (sweep.regionOfNet[netIndex] == worker.region) {
+        static_cast<boundingBox &>(box) = p.nets[netIndex];
+        oldHPWL = box.HPWL;
+        valid = true;
+        if (movesCell1) {
+            valid = box.movePin(candidate.cell1Column, candidate.cell1Row, candidate.cell2Column, candidate.cell2Row);
+        }
+        if (valid && movesCell2) {
+            valid = box.movePin(candidate.cell2Column, candidate.cell2Row, candidate.cell1Column, candidate.cell1Row);
+        }
+    } else {
+        oldHPWL = worker.localStamp[netIndex] == sweepIndex ? worker.localHPWL[netIndex] : p.nets[netIndex].HPWL;
+    }
+    if (!valid) {
+        box.reset();
+        for (int i = design.netPinStart[netIndex]; i < design.netPinStart[netIndex + 1]; i++) {
+            int cellIndex = design.netPins[i];
+            if (cellIndex == candidate.cell1Index) {
+                box.addPin(candidate.cell2Column, candidate.cell2Row);
+            } else if (cellIndex == candidate.cell2Index) {
+                box.addPin(candidate.cell1Column, candidate.cell1Row);
+            } else if (sweep.regionOfCell[cellIndex] == worker.region) {
+                box.addPin(p.cellX[cellIndex], p.cellY[cellIndex]);
+            } else {
+                box.addPin(sweep.snapshotX[cellIndex], sweep.snapshotY[cellIndex]);
+            }
+        }
+        box.HPWL = (box.maxX - box.minX) + (box.maxY - box.minY);
+    }
+    worker.scratch.candidateNets.push_back(box);
+    candidate.deltaHPWL += box.HPWL - oldHPWL;
+}
+
+// Metropolis moves confined to one region: both sites lie inside it, so the thread owns every
+// cell, site and inside net it writes
+static void annealRegion(placement &p, const regionSweep &sweep, regionWorker &worker, int sweepIndex,
+                  double temperature, int moves, int rangeLimit) {
+    const netList &design = *p.design;
+    worker.scratch.metropolis.prepare(temperature);
+    worker.acceptedMoves = 0;
+    if (worker.cells.empty()) {
+        return;
+    }
+    for (int i = 0; i < moves; i++) {
+        swapMove candidate;
+        candidate.cell1Index = worker.cells[randomBelow(worker.rng, worker.cells.size())];
+        candidate.cell1Row = p.cellY[candidate.cell1Index];
+        candidate.cell1Column = p.cellX[candidate.cell1Index];
+        // the move window clipped to the run of the region holding the cell
+        int lowRow = 0, highRow = design.numOfRows - 1, lowColumn = 0, highColumn = design.numOfColumns - 1;
+        if (sweep.columnStripes) {
+            sweep.regionBounds(candidate.cell1Column, lowColumn, highColumn);
+        } else {
+            sweep.regionBounds(candidate.cell1Row, lowRow, highRow);
+        }
+        lowRow = max(lowRow, candidate.cell1Row - rangeLimit);
+        highRow = min(highRow, candidate.cell1Row + rangeLimit);
+        lowColumn = max(lowColumn, candidate.cell1Column - rangeLimit);
+        highColumn = min(highColumn, candidate.cell1Column + rangeLimit);
+        if (lowRow == highRow && lowColumn == highColumn) {
+            continue; // the cell is alone in its window
+        }
+        do {
+            candidate.cell2Row = randomBetween(worker.rng, lowRow, highRow);
+            candidate.cell2Column = randomBetween(worker.rng, lowColumn, highColumn);
+        } while (candidate.cell2Row == candidate.cell1Row && candidate.cell2Column == candidate.cell1Column);
+        candidate.cell2Index = p.grid.at(candidate.cell2Row, candidate.cell2Column);
+
+        candidate.deltaHPWL = 0;
+        worker.scratch.candidateNets.clear();
+        worker.scratch.nextMove();
+        int cell1 = candidate.cell1Index;
+        int cell2 = candidate.cell2Index;
+        if (cell2 != -1) {
+            for (int j = design.cellNetStart[cell2]; j < design.cellNetStart[cell2 + 1]; j++) {
+                worker.scratch.netCell2Stamp[design.cellNets[j]] = worker.scratch.moveStamp;
+            }
+        }
+        for (int j = design.cellNetStart[cell1]; j < design.cellNetStart[cell1 + 1]; j++) {
+            int netIndex = design.cellNets[j];
+            worker.scratch.netMoveStamp[netIndex] = worker.scratch.moveStamp;
+            addRegionCandidateNet(p, sweep, worker, sweepIndex, candidate, netIndex, true, worker.scratch.netCell2Stamp[netIndex] == worker.scratch.moveStamp);
+        }
+        if (cell2 != -1) {
+            for (int j = design.cellNetStart[cell2]; j < design.cellNetStart[cell2 + 1]; j++) {
+                int netIndex = design.cellNets[j];
+                if (worker.scratch.netMoveStamp[netIndex] != worker.scratch.moveStamp) {
+                    addRegionCandidateNet(p, sweep, worker, sweepIndex, candidate, netIndex, false, true);
+                }
+            }
+        }
+
+        if (!worker.scratch.metropolis.accept(candidate.deltaHPWL, worker.rng)) {
+            continue;
+        }
+        p.cellX[cell1] = candidate.cell2Column;
+        p.cellY[cell1] = candidate.cell2Row;
+        p.grid.store(candidate.cell2Row * design.numOfColumns + candidate.cell2Column, cell1);
+        if (cell2 != -1) {
+            p.cellX[cell2] = candidate.cell1Column;
+            p.cellY[cell2] = candidate.cell1Row;
+        }
+        p.grid.store(candidate.cell1Row * design.numOfColumns + candidate.cell1Column, cell2);
+        for (int j = 0; j < worker.scratch.candidateNets.size(); j++) {
+            const candidateNet &box = worker.scratch.candidateNets[j];
+            if (sweep.regionOfNet[box.netIndex] == worker.region) {
+                static_cast<boundingBox &>(p.nets[box.netIndex]) = box;
+            } else {
+                worker.localHPWL[box.netIndex] = box.HPWL;
+                worker.localStamp[box.netIndex] = sweepIndex;
+            }
+        }
+        worker.acceptedMoves++;
+    }
+}
+
+int simulateAnnealingRegions(placement &p, temperatureRange range, coolingSchedule schedule, int regions, uint64_t seed) {
+    const netList &design = *p.design;
+    double currentTemperature = range.initialTemperature;
+    int moves = 10*design.numOfCells;
+    int rangeLimit = max(design.numOfRows, design.numOfColumns) - 1;
+    stagnationTracker stagnation;
+
+    regionSweep sweep;
+    sweep.regions = regions;
+    workerPool pool(regions); // one helper per region, kept for every sweep
+    vector<regionWorker> workers(regions);
+    for (int r = 0; r < regions; r++) {
+        workers[r].region = r;
+        workers[r].scratch.reset(design);
+        workers[r].localHPWL.assign(design.numOfNets, 0);
+        workers[r].localStamp.assign(design.numOfNets, -1);
+        workers[r].rng.seed(deriveSeed(seed, WORKER_STREAM, r));
+    }
+
+    int count = 0;
+    while(currentTemperature > range.finalTemperature) {
+        prepareRegionSweep(p, sweep, count);
+        for (int r = 0; r < regions; r++) {
+            workers[r].cells.clear();
+        }
+        for (int c = 0; c < design.numOfCells; c++) {
+            workers[sweep.regionOfCell[c]].cells.push_back(c);
+        }
+        pool.run(regions, [&](int, int begin, int end) {
+            for (int r = begin; r < end; r++) {
+                int regionMoves = (int)((long long)moves * workers[r].cells.size() / max(1, design.numOfCells));
+                annealRegion(p, sweep, workers[r], count, currentTemperature, regionMoves, rangeLimit);
+            }
+        });
+        int acceptedMoves = 0;
+        for (int r = 0; r < regions; r++) {
+            acceptedMoves += workers[r].acceptedMoves;
+        }
+
+        // reconcile: boundary-crossing nets were only tracked per thread
+        p.grid.rebuildFreeSites();
+        p.totalWireLength = 0;
+        for (int n = 0; n < design.numOfNets; n++) {
+            if (sweep.regionOfNet[n] == -1) {
+                computeHPWLofNet(p, n);
+            }
+            p.totalWireLength += p.nets[n].HPWL;
+        }
+
+        double acceptanceRate = (double)acceptedMoves / moves;
+        rangeLimit = updateRangeLimit(*p.design, rangeLimit, acceptanceRate);
+        count++;
+        if (schedule == ADAPTIVE_COOLING) {
+            if (stagnation.frozen(p.totalWireLength, acceptanceRate)) {
+                break;
+            }
+            currentTemperature = adaptiveCoolingRate(acceptanceRate) * currentTemperature;
+        } else {
+            currentTemperature = 0.95 * currentTemperature;
+        }
+    }
+    return count;
+}
+
+// per-thread state of the lock-free annealer
+struct hogwildWorker {
+    moveScratch scratch;
+    annealRng rng;
+    int acceptedMoves;
+};
+
+int simulateAnnealingHogwild(placement &p, temperatureRange range, coolingSchedule schedule, int threads, uint64_t seed) {
+    const netList &design = *p.design;
+    double currentTemperature = range.initialTemperature;
+    int moves = 10*design.numOfCells;
+    int rangeLimit = max(design.numOfRows, design.numOfColumns) - 1;
+    stagnationTracker stagnation;
+
+    workerPool pool(threads);
+    vector<hogwildWorker> workers(threads);
+    for (int t = 0; t < threads; t++) {
+        workers[t].scratch.reset(design);
+        workers[t].rng.seed(deriveSeed(seed, WORKER_STREAM, t));
+    }
+    vector<atomic<uint8_t>> siteClaims(design.numOfRows * design.numOfColumns);
+    for (int site = 0; site < siteClaims.size(); site++) {
+        siteClaims[site].store(0, memory_order_relaxed);
+    }
+
+    int count = 0;
+    while(currentTemperature > range.finalTemperature) {
+        double temperature = currentTemperature;
+        int currentRangeLimit = rangeLimit;
+        pool.run(threads, [&](int t, int, int) {
+            hogwildWorker &worker = workers[t];
+            worker.scratch.metropolis.prepare(temperature);
+            worker.acceptedMoves = 0;
+            int workerMoves = (int)((long long)moves * (t + 1) / threads - (long long)moves * t / threads);
+            for (int i = 0; i < workerMoves; i++) {
+                swapMove candidate = proposeMoveWith<relaxedAccess>(p, worker.rng, currentRangeLimit);
+                if (candidate.cell1Index == -1) {
+                    continue;
+                }
+                int site1 = candidate.cell1Row * design.numOfColumns + candidate.cell1Column;
+                int site2 = candidate.cell2Row * design.numOfColumns + candidate.cell2Column;
+                if (site1 == site2) {
+                    continue; // positions read while the cells were moving
+                }
+                uint8_t unclaimed = 0;
+                if (!siteClaims[site1].compare_exchange_strong(unclaimed, 1, memory_order_acquire)) {
+                    continue;
+                }
+                unclaimed = 0;
+                if (!siteClaims[site2].compare_exchange_strong(unclaimed, 1, memory_order_acquire)) {
+                    siteClaims[site1].store(0, memory_order_release);
+                    continue;
+                }
+                // with both sites claimed their occupants cannot change under us; the positions of
+                // other cells and the net boxes can, and are read relaxed and possibly stale
+                if (occupantOf<relaxedAccess>(p.grid, site1) == candidate.cell1Index) {
+                    candidate.cell2Index = occupantOf<relaxedAccess>(p.grid, site2);
+                    evaluateMoveWith<relaxedAccess>(p, worker.scratch, candidate);
+                    if (worker.scratch.metropolis.accept(candidate.deltaHPWL, worker.rng)) {
+                        int cell1 = candidate.cell1Index;
+                        int cell2 = candidate.cell2Index;
+                        relaxedAccess::store(p.cellX[cell1], candidate.cell2Column);
+                        relaxedAccess::store(p.cellY[cell1], candidate.cell2Row);
+                        storeOccupant<relaxedAccess>(p.grid, site2, cell1);
+                        if (cell2 != -1) {
+                            relaxedAccess::store(p.cellX[cell2], candidate.cell1Column);
+                            relaxedAccess::store(p.cellY[cell2], candidate.cell1Row);
+                        }
+                        storeOccupant<relaxedAccess>(p.grid, site1, cell2);
+                        for (int j = 0; j < worker.scratch.candidateNets.size(); j++) {
+                            const candidateNet &box = worker.scratch.candidateNets[j];
+                            copyBox<relaxedAccess>(p.nets[box.netIndex], box);
+                        }
+                        worker.acceptedMoves++;
+                    }
+                }
+                siteClaims[site2].store(0, memory_order_release);
+                siteClaims[site1].store(0, memory_order_release);
+            }
+        });
+        int acceptedMoves = 0;
+        for (int t = 0; t < threads; t++) {
+            acceptedMoves += workers[t].acceptedMoves;
+        }
+
+        // resynchronize everything the threads let drift
+        p.grid.rebuildFreeSites();
+        computeHPWLofAllNets(p);
+
+        double acceptanceRate = (double)acceptedMoves / moves;
+        rangeLimit = updateRangeLimit(*p.design, rangeLimit, acceptanceRate);
+        count++;
+        if (schedule == ADAPTIVE_COOLING) {
+            if (stagnation.frozen(p.totalWireLength, acceptanceRate)) {
+                break;
+            }
+            currentTemperature = adaptiveCoolingRate(acceptanceRate) * currentTemperature;
+        } else {
+            currentTemperature = 0.95 * currentTemperature;
+        }
+    }
+    return count;
+}
+
+temperingResult runParallelTempering(const netList &design, placement &best, int replicas, int epochs, temperatureRange range, uint64_t seed) {
+    vector<placement> states(replicas);
+    vector<int> stateAtRung(replicas);
+    vector<double> ladder(replicas);
+    vector<int> rangeLimits(replicas, max(design.numOfRows, design.numOfColumns) - 1);
+    vector<annealRng> rngs;
+    temperingResult result;
+    result.attemptedExchanges = result.acceptedExchanges = 0;
+    result.finalWireLength = INT_MAX;
+    result.placed = true;
+    for (int k = 0; k < replicas; k++) {
+        resetPlacement(states[k], design);
+        if (!placeInitiallyRandom(states[k], deriveSeed(seed, START_STREAM, k))) {
+            result.placed = false;
+            return result;
+        }
+        computeHPWLofAllNets(states[k]);
+        stateAtRung[k] = k;
+        double fraction = replicas == 1 ? 0 : (double)k / (replicas - 1);
+        ladder[k] = range.finalTemperature * pow(range.initialTemperature / range.finalTemperature, fraction);
+        rngs.emplace_back(deriveSeed(seed, WORKER_STREAM, k));
+    }
+    annealRng exchangeRng(deriveSeed(seed, EXCHANGE_STREAM));
+    int moves = design.numOfCells;
+
+    // one helper per rung for the whole run, epochs are too short to start threads for each
+    workerPool pool(replicas);
+    vector<int> acceptedMoves(replicas);
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        pool.run(replicas, [&](int worker, int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                acceptedMoves[k] = annealMoves(states[stateAtRung[k]], ladder[k], moves, rangeLimits[k], rngs[k]);
+            }
+        });
+        for (int k = 0; k < replicas; k++) {
+            rangeLimits[k] = updateRangeLimit(design, rangeLimits[k], (double)acceptedMoves[k] / max(1, moves));
+            placement &state = states[stateAtRung[k]];
+            if (state.totalWireLength < result.finalWireLength) {
+                result.finalWireLength = state.totalWireLength;
+                best = state;
+            }
+        }
+        for (int k = epoch % 2; k + 1 < replicas; k += 2) {
+            int costOfCold = states[stateAtRung[k]].totalWireLength;
+            int costOfHot = states[stateAtRung[k + 1]].totalWireLength;
+            double exponent = (1.0 / ladder[k] - 1.0 / ladder[k + 1]) * (costOfCold - costOfHot);
+            result.attemptedExchanges++;
+            if (exponent >= 0 || randomUnit(exchangeRng) < exp(exponent)) {
+                swap(stateAtRung[k], stateAtRung[k + 1]);
+                result.acceptedExchanges++;
+            }
+        }
+    }
+    return result;
+}
+
+startResult runPlacement(const netList &design, placement &p, int start, uint64_t seed, coolingSchedule schedule, bool calibrate) {
+    auto startTime = high_resolution_clock::now();
+    startResult result;
+    result.start = start;
+    result.seed = seed;
+    resetPlacement(p, design);
+    result.placed = placeInitiallyRandom(p, seed);
+    if (!result.placed) {
+        result.initialWireLength = result.finalWireLength = INT_MAX;
+        result.temperatureSteps = 0;
+        result.seconds = 0;
+        return result;
+    }
+    computeHPWLofAllNets(p);
+    result.initialWireLength = p.totalWireLength;
+    temperatureRange range = legacyTemperatureRange(*p.design, p.totalWireLength);
+    if (calibrate) {
+        range = calibrateTemperatureRange(p, 4000, seed);
+    }
+    result.temperatureSteps = simulateAnnealingFast(p, range, schedule, seed);
+    result.finalWireLength = p.totalWireLength;
+    result.seconds = duration_cast<duration<double>>(high_resolution_clock::now() - startTime).count();
+    return result;
+}
+
+vector<startResult> runMultiStart(const netList &design, int starts, int threads, coolingSchedule schedule, bool calibrate, uint64_t baseSeed, placement &best) {
+    vector<startResult> results(starts);
+    atomic<int> nextStart(0);
+    mutex bestMutex;
+    int bestStart = -1;
+
+    auto worker = [&]() {
+        placement p;
+        for (int start = nextStart++; start < starts; start = nextStart++) {
+            startResult result = runPlacement(design, p, start, deriveSeed(baseSeed, START_STREAM, start), schedule, calibrate);
+            results[start] = result;
+            if (!result.placed) {
+                continue;
+            }
+            lock_guard<mutex> lock(bestMutex);
+            if (bestStart == -1 || result.finalWireLength < results[bestStart].finalWireLength ||
+                (result.finalWireLength == results[bestStart].finalWireLength && start < bestStart)) {
+                bestStart = start;
+                best = p;
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    for (int i = 0; i < pool.size(); i++) {
+        pool[i].join();
+    }
+    return results;
+}
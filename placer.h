@@ -0,0 +1,952 @@
+// simulated annealing placement library. A netList is parsed once and read-only afterwards;
+// every placement, annealer and result below owns its own state, so any number of placements can
+// be annealed concurrently in one process against the same netlist or different ones.
+#ifndef PLACER_H
+#define PLACER_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+// bounding box of a net's pins together with how many pins sit on each edge
+// so moving one pin only needs a rescan when it was the last pin on an edge
+struct boundingBox{
+    int minX, minY, maxX, maxY;
+    int minXCount, minYCount, maxXCount, maxYCount;
+    int HPWL;
+
+    void reset() {
+        minX = minY = INT_MAX;
+        maxX = maxY = INT_MIN;
+        minXCount = minYCount = maxXCount = maxYCount = 0;
+    }
+
+    void addPin(int x, int y) {
+        addToMinEdge(minX, minXCount, x);
+        addToMaxEdge(maxX, maxXCount, x);
+        addToMinEdge(minY, minYCount, y);
+        addToMaxEdge(maxY, maxYCount, y);
+    }
+
+    // returns false when an edge lost its last pin and the box has to be rescanned
+    bool movePin(int oldX, int oldY, int newX, int newY) {
+        bool valid = moveOnMinEdge(minX, minXCount, oldX, newX);
+        valid = moveOnMaxEdge(maxX, maxXCount, oldX, newX) && valid;
+        valid = moveOnMinEdge(minY, minYCount, oldY, newY) && valid;
+        valid = moveOnMaxEdge(maxY, maxYCount, oldY, newY) && valid;
+        HPWL = (maxX - minX) + (maxY - minY);
+        return valid;
+    }
+
+private:
+    static void addToMinEdge(int &edge, int &count, int value) {
+        if (value < edge) {
+            edge = value;
+            count = 1;
+        } else if (value == edge) {
+            count++;
+        }
+    }
+
+    static void addToMaxEdge(int &edge, int &count, int value) {
+        if (value > edge) {
+            edge = value;
+            count = 1;
+        } else if (value == edge) {
+            count++;
+        }
+    }
+
+    static bool moveOnMinEdge(int &edge, int &count, int oldValue, int newValue) {
+        if (newValue < edge) {
+            edge = newValue;
+            count = 1;
+        } else if (newValue == edge) {
+            if (oldValue != edge) {
+                count++;
+            }
+        } else if (oldValue == edge) {
+            count--;
+            return count > 0;
+        }
+        return true;
+    }
+
+    static bool moveOnMaxEdge(int &edge, int &count, int oldValue, int newValue) {
+        if (newValue > edge) {
+            edge = newValue;
+            count = 1;
+        } else if (newValue == edge) {
+            if (oldValue != edge) {
+                count++;
+            }
+        } else if (oldValue == edge) {
+            count--;
+            return count > 0;
+        }
+        return true;
+    }
+};
+
+// row-major occupancy of the placement sites, -1 marks an empty site
+// cell ids are stored off by one (0 is empty) in 16 bits when the netlist fits and in 32 bits otherwise
+// freeSites lists the empty sites in no particular order, freeSlot[site] is the site's index in it or -1
+struct placementGrid{
+    int rows = 0, columns = 0;
+    bool narrow = true;
+    std::vector<uint16_t> narrowSites;
+    std::vector<uint32_t> wideSites;
+    std::vector<int> freeSites;
+    std::vector<int> freeSlot;
+
+    void resize(int numOfRows, int numOfColumns, int numOfCells) {
+        rows = numOfRows;
+        columns = numOfColumns;
+        narrow = numOfCells < UINT16_MAX;
+        narrowSites.clear();
+        wideSites.clear();
+        if (narrow) {
+            narrowSites.assign((size_t)rows * columns, 0);
+        } else {
+            wideSites.assign((size_t)rows * columns, 0);
+        }
+        freeSites.resize((size_t)rows * columns);
+        freeSlot.resize((size_t)rows * columns);
+        for(int site = 0; site < rows * columns; site++) {
+            freeSites[site] = site;
+            freeSlot[site] = site;
+        }
+    }
+
+    int atSite(int site) const {
+        return narrow ? (int)narrowSites[site] - 1 : (int)wideSites[site] - 1;
+    }
+
+    int at(int row, int column) const {
+        return atSite(row * columns + column);
+    }
+
+    void set(int row, int column, int cellIndex) {
+        int site = row * columns + column;
+        if (cellIndex == -1 && freeSlot[site] == -1) {
+            freeSlot[site] = freeSites.size();
+            freeSites.push_back(site);
+        } else if (cellIndex != -1 && freeSlot[site] != -1) {
+            int lastSite = freeSites.back();
+            freeSites[freeSlot[site]] = lastSite;
+            freeSlot[lastSite] = freeSlot[site];
+            freeSites.pop_back();
+            freeSlot[site] = -1;
+        }
+        store(site, cellIndex);
+    }
+
+    // writes a site without maintaining the free-site list, for threads that own disjoint sites;
+    // call rebuildFreeSites() once they are done
+    void store(int site, int cellIndex) {
+        if (narrow) {
+            narrowSites[site] = (uint16_t)(cellIndex + 1);
+        } else {
+            wideSites[site] = (uint32_t)(cellIndex + 1);
+        }
+    }
+
+    void rebuildFreeSites() {
+        freeSites.clear();
+        for(int site = 0; site < rows * columns; site++) {
+            if (atSite(site) == -1) {
+                freeSlot[site] = freeSites.size();
+                freeSites.push_back(site);
+            } else {
+                freeSlot[site] = -1;
+            }
+        }
+    }
+};
+
+// netlist connectivity in compressed sparse row form, built once by parseNetListFile() and read-only
+// afterwards, so any number of placements and threads can share one
+// pins of net n are netPins[netPinStart[n] .. netPinStart[n+1])
+// nets of cell c are cellNets[cellNetStart[c] .. cellNetStart[c+1])
+struct netList {
+    int numOfCells = 0;
+    int numOfNets = 0;
+    int numOfRows = 0, numOfColumns = 0;
+    std::vector<int> netPinStart, netPins;
+    std::vector<int> cellNetStart, cellNets;
+};
+
+// xoshiro256** (Blackman and Vigna): 64 random bits from a few shifts and xors, where minstd_rand
+// spends a 64-bit modulo on 31 bits. It is a UniformRandomBitGenerator, so <random> works with it.
+struct xoshiro256 {
+    typedef uint64_t result_type;
+    uint64_t state[4];
+
+    explicit xoshiro256(uint64_t seedValue = 1) {
+        seed(seedValue);
+    }
+
+    // expands the seed with splitmix64, which never leaves the state all zero
+    void seed(uint64_t seedValue) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t z = (seedValue += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+private:
+    static uint64_t rotateLeft(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// generator behind every annealing move; any generator with 64 random bits per call can be put here
+typedef xoshiro256 annealRng;
+
+// random streams of a run; each one is seeded from the run seed by deriveSeed(), so a run is
+// reproduced by its seed and thread count alone
+enum seedStream { PLACEMENT_STREAM, CALIBRATION_STREAM, MOVE_STREAM, WORKER_STREAM, EXCHANGE_STREAM, START_STREAM, SWEEP_STREAM, TRACE_STREAM };
+
+// seed of stream number index of a run, mixed with the splitmix64 finalizer so that neighbouring
+// run seeds, streams and indices give unrelated generator states
+uint64_t deriveSeed(uint64_t seed, seedStream stream, uint64_t index = 0);
+
+// uniform integer in [0, n) by multiply-shift instead of the division in uniform_int_distribution;
+// the bias is at most n / 2^32
+inline int randomBelow(annealRng &rng, int n) {
+    return (int)(((rng() >> 32) * (uint64_t)n) >> 32);
+}
+
+// uniform integer in [low, high]
+inline int randomBetween(annealRng &rng, int low, int high) {
+    return low + randomBelow(rng, high - low + 1);
+}
+
+// uniform double in [0, 1) from the top 53 bits
+inline double randomUnit(annealRng &rng) {
+    return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Metropolis acceptance for one temperature: HPWL changes are small integers, so the thresholds
+// exp(-delta/T) are tabulated once per temperature and the inner loop never calls exp()
+struct metropolisTable {
+    double temperature = -1;
+    std::vector<double> thresholds;
+    bool complete = false; // the table reaches deltas no draw can accept
+
+    void prepare(double newTemperature) {
+        if (newTemperature == temperature) {
+            return;
+        }
+        temperature = newTemperature;
+        // from 37*T on exp(-delta/T) is below 2^-53, the resolution of randomUnit()
+        double cutoff = std::ceil(37 * temperature);
+        complete = cutoff < 1024;
+        thresholds.resize(complete ? (int)cutoff + 1 : 1024);
+        for (int delta = 0; delta < thresholds.size(); delta++) {
+            thresholds[delta] = std::exp(-1*(double)delta/temperature);
+        }
+    }
+
+    // draws only for uphill moves, so the number of draws per move is the same as with exp()
+    bool accept(int deltaHPWL, annealRng &rng) const {
+        if (deltaHPWL < 0) {
+            return true;
+        }
+        double randomNumber = randomUnit(rng);
+        if (deltaHPWL < thresholds.size()) {
+            return randomNumber <= thresholds[deltaHPWL];
+        }
+        return !complete && randomNumber <= std::exp(-1*(double)deltaHPWL/temperature);
+    }
+};
+
+// a candidate swap: cell1 moves to (cell2Row, cell2Column) and cell2 moves to (cell1Row, cell1Column)
+// cell1Index is always a real cell, cell2Index is -1 when the target site is empty
+struct swapMove {
+    int cell1Index, cell2Index;
+    int cell1Row, cell1Column, cell2Row, cell2Column;
+    int deltaHPWL;
+};
+
+// bounding box a net would have if the move under evaluation were committed
+struct candidateNet : boundingBox {
+    int netIndex;
+};
+
+// scratch space filled by evaluateMove() and consumed by commitMove(), one per evaluating thread
+struct moveScratch {
+    std::vector<candidateNet> candidateNets;
+    std::vector<uint32_t> netMoveStamp;  // net already added to candidateNets for this move
+    std::vector<uint32_t> netCell2Stamp; // net is also connected to cell2 of this move
+    uint32_t moveStamp = 0;
+    metropolisTable metropolis; // acceptance thresholds of the temperature last annealed at
+
+    void reset(const netList &design) {
+        candidateNets.clear();
+        netMoveStamp.assign(design.numOfNets, 0);
+        netCell2Stamp.assign(design.numOfNets, 0);
+        moveStamp = 0;
+    }
+
+    // starts the stamps of a new move; on wrap-around the arrays are cleared so that a stamp
+    // left by a move 2^32 moves ago cannot match
+    void nextMove() {
+        if (++moveStamp == 0) {
+            std::fill(netMoveStamp.begin(), netMoveStamp.end(), 0);
+            std::fill(netCell2Stamp.begin(), netCell2Stamp.end(), 0);
+            moveStamp = 1;
+        }
+    }
+};
+
+// everything an anneal changes, one per independent run; the netlist is shared read-only
+struct placement {
+    const netList *design = nullptr; // the netlist being placed, set by resetPlacement()
+    // cell positions, x is column number and y is row number
+    std::vector<int> cellX, cellY;
+    std::vector<boundingBox> nets; // one box per net, indexed like netPinStart
+    placementGrid grid;
+    int totalWireLength = 0; // running sum of nets[i].HPWL, kept current by commitMove()
+    moveScratch scratch;      // used by the single-threaded evaluateMove()/commitMove()
+};
+
+// writes the parsed netlist in binary form; the file appears under its name only once complete,
+// so concurrent runs never load half a cache
+bool writeBinaryNetList(const netList &design, const std::string &fileName, uint64_t sourceSize = 0, int64_t sourceModified = 0);
+
+// reads a text or binary netlist. A large text netlist is cached as <file>.cache in binary form,
+// keyed on its size and modification time, and later runs load the cache instead of parsing.
+// Returns false after reporting why when the file cannot be read or is malformed.
+bool parseNetListFile(netList &design, std::string netListFileName, int threads = 0, bool useCache = true);
+
+// sizes a placement for a parsed netlist with every cell unplaced; the netlist must outlive it
+void resetPlacement(placement &p, const netList &design);
+
+// places every cell on a random free site of a freshly reset placement; returns false when the
+// netlist has more cells than the grid has sites
+bool placeInitiallyRandom(placement &p, uint64_t seed);
+int computeHPWLofNet(placement &p, int netIndex);
+void computeHPWLofAllNets(placement &p);
+
+// instruction sets of the bounding-box kernel; the one detectHPWLKernel() picks at run time, AVX2
+// when supported, is used by computeHPWLofNet() and computeHPWLofAllNets() for every net of more
+// than 2 pins, and the SIMD kernels hand nets below their vector width to the scalar one
+enum hpwlKernel { SCALAR_HPWL, AVX2_HPWL, AVX512_HPWL };
+
+hpwlKernel detectHPWLKernel();
+bool hpwlKernelSupported(hpwlKernel kernel);
+const char *hpwlKernelName(hpwlKernel kernel);
+
+// recomputes the boxes of the listed nets with the kernel of the given instruction set and returns
+// the sum of their HPWL; used to compare the kernels
+int computeHPWLofNets(placement &p, const std::vector<int> &nets, hpwlKernel kernel);
+int computeTotalWireLength(const placement &p);
+
+// picks a random cell and a random destination among the other cells and the free sites,
+// which is uniform over every site except the cell's own, so no move is spent on two empty sites
+// when rangeLimit is smaller than the grid the destination is drawn from the window of sites
+// within rangeLimit rows and columns of the cell instead
+swapMove proposeMove(const placement &p, annealRng &rng, int rangeLimit);
+
+// computes the wire length change of a move into scratch space without touching grid, cells or nets,
+// so several threads can evaluate moves against the same placement with their own scratch
+int evaluateMove(const placement &p, moveScratch &scratch, swapMove &candidate);
+
+int evaluateMove(placement &p, swapMove &candidate);
+
+// applies a move together with the candidate boxes evaluateMove() computed for it
+void commitMove(placement &p, const std::vector<candidateNet> &candidateNets, const swapMove &candidate);
+
+// applies the move last passed to evaluateMove(p, candidate)
+void commitMove(placement &p, const swapMove &candidate);
+
+bool detectTwoEmptyCells(const placement &p);
+
+// TimberWolf/VPR range limiter: grow the move window when many moves are accepted and shrink it
+// when few are, aiming for an acceptance rate of about 0.44
+int updateRangeLimit(const netList &design, int rangeLimit, double acceptanceRate);
+
+struct temperatureRange {
+    double initialTemperature;
+    double finalTemperature;
+};
+
+// the original schedule bounds, scaled from the initial wire length
+temperatureRange legacyTemperatureRange(const netList &design, int initialCost);
+
+// warm-up phase: evaluates random moves on the current placement without committing them
+// and derives the schedule from the spread of their wire length change. The anneal starts at
+// 20 standard deviations (VPR) and ends where the smallest uphill change seen is accepted
+// with a probability of 0.1%. Falls back to the legacy range when no move changes the cost.
+temperatureRange calibrateTemperatureRange(placement &p, int samples, uint64_t seed);
+
+// number of temperature steps a geometric schedule takes to cool through a range
+int geometricSteps(temperatureRange range, double coolingRate);
+
+enum coolingSchedule { GEOMETRIC_COOLING, ADAPTIVE_COOLING };
+
+// Lam/VPR-style cooling factor: cool quickly while nearly every move or almost no move is
+// accepted and slowly in the band where the placement actually improves
+inline double adaptiveCoolingRate(double acceptanceRate) {
+    if (acceptanceRate > 0.96) {
+        return 0.5;
+    } else if (acceptanceRate > 0.8) {
+        return 0.9;
+    } else if (acceptanceRate > 0.15) {
+        return 0.95;
+    }
+    return 0.8;
+}
+
+// stop criterion of the adaptive schedule: the anneal is frozen once hardly any move is accepted
+// and the best wire length has not improved for a few temperature steps
+struct stagnationTracker {
+    int bestCost = INT_MAX;
+    int stepsWithoutImprovement = 0;
+
+    bool frozen(int cost, double acceptanceRate) {
+        if (cost < bestCost) {
+            bestCost = cost;
+            stepsWithoutImprovement = 0;
+        } else {
+            stepsWithoutImprovement++;
+        }
+        return stepsWithoutImprovement >= 5 && acceptanceRate < 0.02;
+    }
+};
+
+// convergence trace of an anneal in fixed memory. Every temperature step becomes one CSV row of
+// aggregates, written as soon as the step ends; optionally a uniform reservoir sample of the
+// per-move wire lengths is kept for the whole anneal.
+struct traceRecorder {
+    struct moveSample {
+        long long move;
+        double temperature;
+        int wireLength;
+    };
+
+    std::ostream *stepFile = nullptr; // receives the step rows, none when null
+    std::string rowPrefix;            // leading columns of every row, such as the cooling rate
+    int reservoirSize = 0;
+    std::vector<moveSample> reservoir;
+    long long movesSeen = 0;
+    annealRng rng;
+
+    // the step in progress
+    int stepMoves = 0;
+    int stepMinimum = INT_MAX, stepMaximum = INT_MIN;
+    long long stepSum = 0;
+
+    traceRecorder(std::ostream *stepFile, uint64_t seed, int reservoirSize = 0)
+        : stepFile(stepFile), reservoirSize(reservoirSize), rng(deriveSeed(seed, TRACE_STREAM)) {
+        reservoir.reserve(reservoirSize);
+    }
+
+    static void writeStepHeader(std::ostream &file, const std::string &prefixColumns = "") {
+        file << prefixColumns << "Temperature,Wirelength,Min Wirelength,Mean Wirelength,Max Wirelength,Acceptance Rate,Moves\n";
+    }
+
+    // wire length after a move, accepted or not
+    void recordMove(double temperature, int wireLength) {
+        stepMoves++;
+        stepSum += wireLength;
+        stepMinimum = std::min(stepMinimum, wireLength);
+        stepMaximum = std::max(stepMaximum, wireLength);
+        movesSeen++;
+        if (reservoir.size() < reservoirSize) {
+            reservoir.push_back({movesSeen - 1, temperature, wireLength});
+        } else if (reservoirSize > 0) {
+            // Algorithm R: keep the move with probability reservoirSize / movesSeen
+            uint64_t slot = (uint64_t)(((unsigned __int128)rng() * (uint64_t)movesSeen) >> 64);
+            if (slot < reservoirSize) {
+                reservoir[slot] = {movesSeen - 1, temperature, wireLength};
+            }
+        }
+    }
+
+    // closes the step annealed at temperature, with wireLength the cost it ended at
+    void endStep(double temperature, int acceptedMoves, int wireLength) {
+        if (stepFile != nullptr && stepMoves > 0) {
+            *stepFile << rowPrefix << temperature << "," << wireLength << "," << stepMinimum << ","
+                      << (double)stepSum / stepMoves << "," << stepMaximum << ","
+                      << (double)acceptedMoves / stepMoves << "," << stepMoves << "\n";
+        }
+        stepMoves = 0;
+        stepMinimum = INT_MAX;
+        stepMaximum = INT_MIN;
+        stepSum = 0;
+    }
+
+    void writeSamples(std::ostream &file) {
+        std::sort(reservoir.begin(), reservoir.end(), [](const moveSample &a, const moveSample &b) { return a.move < b.move; });
+        file << "Move,Temperature,Wirelength\n";
+        for (int i = 0; i < reservoir.size(); i++) {
+            file << reservoir[i].move << "," << reservoir[i].temperature << "," << reservoir[i].wireLength << "\n";
+        }
+    }
+};
+
+// runs a batch of Metropolis moves at a fixed temperature and returns how many were accepted;
+// records the wire length after every move in trace when one is given
+int annealMoves(placement &p, double temperature, int moves, int rangeLimit, annealRng &rng, traceRecorder *trace = nullptr);
+
+// fixed set of helper threads that run one job over slices of an index range at a time;
+// the calling thread works on the first slice and run() returns once every slice is done
+struct workerPool {
+    int threads;
+    std::vector<std::thread> helpers;
+    std::mutex poolMutex;
+    std::condition_variable wake, finished;
+    std::function<void(int, int, int)> job;
+    int count = 0, generation = 0, pending = 0;
+    bool stopping = false;
+
+    explicit workerPool(int threads) : threads(threads) {
+        for (int worker = 1; worker < threads; worker++) {
+            helpers.emplace_back(&workerPool::helperLoop, this, worker);
+        }
+    }
+
+    ~workerPool() {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (int i = 0; i < helpers.size(); i++) {
+            helpers[i].join();
+        }
+    }
+
+    // job(worker, begin, end) handles indices [begin, end) of [0, count)
+    void run(int count, std::function<void(int, int, int)> job) {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            this->job = job;
+            this->count = count;
+            pending = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        runSlice(0);
+        std::unique_lock<std::mutex> lock(poolMutex);
+        finished.wait(lock, [this]() { return pending == 0; });
+    }
+
+private:
+    void runSlice(int worker) {
+        int begin = (long long)count * worker / threads;
+        int end = (long long)count * (worker + 1) / threads;
+        if (begin < end) {
+            job(worker, begin, end);
+        }
+    }
+
+    void helperLoop(int worker) {
+        int seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(poolMutex);
+                wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping) {
+                    return;
+                }
+                seenGeneration = generation;
+            }
+            runSlice(worker);
+            {
+                std::lock_guard<std::mutex> lock(poolMutex);
+                pending--;
+            }
+            finished.notify_one();
+        }
+    }
+};
+
+// a proposal of a speculative batch with the candidate boxes it was evaluated to
+struct speculativeMove {
+    swapMove candidate;
+    std::vector<candidateNet> candidateNets;
+};
+
+// speculative parallel evaluation for the low-acceptance tail of an anneal: proposals are drawn
+// in batches, evaluated concurrently against the unchanged placement, then accepted or rejected in
+// order. Once a move of the batch is committed, later proposals that share one of its cells,
+// sites or nets are re-evaluated against the current placement first, so every decision uses the
+// exact wire length change a sequential anneal would have seen.
+struct speculativeAnnealer {
+    workerPool pool;
+    int batchSize;
+    std::vector<moveScratch> scratches; // one per worker
+    std::vector<speculativeMove> batch;
+    std::vector<uint32_t> cellStamp, siteStamp, netStamp; // touched by a move committed in the current batch
+    uint32_t batchStamp = 0;
+    int reevaluatedMoves = 0;
+
+    explicit speculativeAnnealer(int threads) : pool(threads), batchSize(64 * threads), scratches(threads) {}
+
+    // one temperature step on the policies of annealWith(); the cost model's scratch-space evaluate()
+    // is called from every worker at once and must only read the placement
+    template <class moveGenerator, class costModel, class recorder>
+    int annealMoves(placement &p, double temperature, int moves, moveGenerator &generator, costModel &cost,
+                    recorder &trace, annealRng &rng) {
+        const netList &design = *p.design;
+        // sized on every array, as the annealer may be reused on another netlist or grid
+        if (cellStamp.size() != design.numOfCells || netStamp.size() != design.numOfNets ||
+            siteStamp.size() != (size_t)design.numOfRows * design.numOfColumns) {
+            for (int i = 0; i < scratches.size(); i++) {
+                scratches[i].reset(design);
+            }
+            batch.resize(batchSize);
+            cellStamp.assign(design.numOfCells, 0);
+            siteStamp.assign((size_t)design.numOfRows * design.numOfColumns, 0);
+            netStamp.assign(design.numOfNets, 0);
+        }
+        metropolisTable &metropolis = p.scratch.metropolis;
+        metropolis.prepare(temperature);
+        int acceptedMoves = 0;
+        for (int done = 0; done < moves; done += batchSize) {
+            int batchMoves = std::min(batchSize, moves - done);
+            for (int i = 0; i < batchMoves; i++) {
+                batch[i].candidate = generator.propose(p, rng);
+            }
+            const placement &snapshot = p;
+            pool.run(batchMoves, [&](int worker, int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    cost.evaluate(snapshot, scratches[worker], batch[i].candidate);
+                    // trade buffers instead of copying, the scratch gets the slot's old one to refill
+                    batch[i].candidateNets.swap(scratches[worker].candidateNets);
+                }
+            });
+
+            if (++batchStamp == 0) {
+                // wrapped, clear the stamps of batches 2^32 batches ago
+                std::fill(cellStamp.begin(), cellStamp.end(), 0);
+                std::fill(siteStamp.begin(), siteStamp.end(), 0);
+                std::fill(netStamp.begin(), netStamp.end(), 0);
+                batchStamp = 1;
+            }
+            bool committed = false;
+            for (int i = 0; i < batchMoves; i++) {
+                swapMove &candidate = batch[i].candidate;
+                const std::vector<candidateNet> *candidateNets = &batch[i].candidateNets;
+                if (committed && conflicts(design, candidate)) {
+                    // keep the destination site, take cell positions and occupants as they are now
+                    candidate.cell1Row = p.cellY[candidate.cell1Index];
+                    candidate.cell1Column = p.cellX[candidate.cell1Index];
+                    candidate.cell2Index = p.grid.at(candidate.cell2Row, candidate.cell2Column);
+                    reevaluatedMoves++;
+                    if (candidate.cell2Row == candidate.cell1Row && candidate.cell2Column == candidate.cell1Column) {
+                        // the cell already sits there: no move to decide, so none to count as accepted
+                        trace.recordMove(temperature, p.totalWireLength);
+                        continue;
+                    }
+                    cost.evaluate(p, p.scratch, candidate);
+                    candidateNets = &p.scratch.candidateNets;
+                }
+                if (metropolis.accept(candidate.deltaHPWL, rng)) {
+                    cost.commit(p, *candidateNets, candidate);
+                    markTouched(design, candidate, *candidateNets);
+                    committed = true;
+                    acceptedMoves++;
+                }
+                trace.recordMove(temperature, p.totalWireLength);
+            }
+        }
+        return acceptedMoves;
+    }
+
+private:
+    bool conflicts(const netList &design, const swapMove &candidate) const {
+        if (candidate.cell1Index == -1) {
+            return false;
+        }
+        if (cellStamp[candidate.cell1Index] == batchStamp ||
+            (candidate.cell2Index != -1 && cellStamp[candidate.cell2Index] == batchStamp) ||
+            siteStamp[candidate.cell1Row * design.numOfColumns + candidate.cell1Column] == batchStamp ||
+            siteStamp[candidate.cell2Row * design.numOfColumns + candidate.cell2Column] == batchStamp) {
+            return true;
+        }
+        for (int i = design.cellNetStart[candidate.cell1Index]; i < design.cellNetStart[candidate.cell1Index + 1]; i++) {
+            if (netStamp[design.cellNets[i]] == batchStamp) {
+                return true;
+            }
+        }
+        if (candidate.cell2Index != -1) {
+            for (int i = design.cellNetStart[candidate.cell2Index]; i < design.cellNetStart[candidate.cell2Index + 1]; i++) {
+                if (netStamp[design.cellNets[i]] == batchStamp) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void markTouched(const netList &design, const swapMove &candidate, const std::vector<candidateNet> &candidateNets) {
+        if (candidate.cell1Index == -1) {
+            return;
+        }
+        cellStamp[candidate.cell1Index] = batchStamp;
+        if (candidate.cell2Index != -1) {
+            cellStamp[candidate.cell2Index] = batchStamp;
+        }
+        siteStamp[candidate.cell1Row * design.numOfColumns + candidate.cell1Column] = batchStamp;
+        siteStamp[candidate.cell2Row * design.numOfColumns + candidate.cell2Column] = batchStamp;
+        for (int i = 0; i < candidateNets.size(); i++) {
+            netStamp[candidateNets[i].netIndex] = batchStamp;
+        }
+    }
+};
+
+// below this acceptance rate the anneal is in its tail and speculation pays off
+const double speculationAcceptanceRate = 0.15;
+
+// Policies of annealWith(). A move generator proposes moves and adapts after every temperature
+// step, a cost model prices and applies them, a schedule cools and decides when the anneal is
+// frozen, a recorder observes moves and steps and a stepper runs the moves of each step. They are
+// plain structs passed by value, so every combination is compiled into a loop of its own with the
+// policy calls inlined.
+
+// uniform swaps within the range limiter's window
+struct rangeLimitedMoves {
+    int rangeLimit = 0;
+
+    void start(const placement &p) {
+        rangeLimit = std::max(p.design->numOfRows, p.design->numOfColumns) - 1;
+    }
+
+    swapMove propose(const placement &p, annealRng &rng) const {
+        return proposeMove(p, rng, rangeLimit);
+    }
+
+    void endStep(const placement &p, double acceptanceRate) {
+        rangeLimit = updateRangeLimit(*p.design, rangeLimit, acceptanceRate);
+    }
+};
+
+// half-perimeter wire length, updated incrementally from the boxes of the moved cells' nets.
+// The scratch-space overloads are the ones speculativeSteps needs on top of the other two.
+struct incrementalHPWL {
+    int evaluate(placement &p, swapMove &candidate) const {
+        return evaluateMove(p, candidate);
+    }
+
+    void commit(placement &p, const swapMove &candidate) const {
+        commitMove(p, candidate);
+    }
+
+    int evaluate(const placement &p, moveScratch &scratch, swapMove &candidate) const {
+        return evaluateMove(p, scratch, candidate);
+    }
+
+    void commit(placement &p, const std::vector<candidateNet> &candidateNets, const swapMove &candidate) const {
+        commitMove(p, candidateNets, candidate);
+    }
+};
+
+// cool() lowers the temperature after a step and returns false once the anneal is frozen
+struct geometricSchedule {
+    double coolingRate;
+
+    bool cool(double &temperature, int cost, double acceptanceRate) {
+        temperature = coolingRate * temperature;
+        return true;
+    }
+};
+
+struct adaptiveSchedule {
+    stagnationTracker stagnation;
+
+    bool cool(double &temperature, int cost, double acceptanceRate) {
+        if (stagnation.frozen(cost, acceptanceRate)) {
+            return false;
+        }
+        temperature = adaptiveCoolingRate(acceptanceRate) * temperature;
+        return true;
+    }
+};
+
+// recorder of the fast variant, compiles away
+struct noTrace {
+    void recordMove(double temperature, int wireLength) {}
+    void endStep(double temperature, int acceptedMoves, int wireLength) {}
+};
+
+// recorder of the instrumented variant
+struct recordTrace {
+    traceRecorder *trace;
+
+    void recordMove(double temperature, int wireLength) { trace->recordMove(temperature, wireLength); }
+    void endStep(double temperature, int acceptedMoves, int wireLength) { trace->endStep(temperature, acceptedMoves, wireLength); }
+};
+
+// one temperature step of annealWith(): a batch of Metropolis moves, returns how many were accepted
+template <class moveGenerator, class costModel, class recorder>
+int annealMovesWith(placement &p, double temperature, int moves, moveGenerator &generator, costModel &cost,
+                    recorder &trace, annealRng &rng) {
+    metropolisTable &metropolis = p.scratch.metropolis;
+    metropolis.prepare(temperature);
+    int acceptedMoves = 0;
+    for(int i = 0; i < moves; i++) {
+        swapMove candidate = generator.propose(p, rng);
+        int deltaHPWL = cost.evaluate(p, candidate);
+        if(metropolis.accept(deltaHPWL, rng)) {
+            cost.commit(p, candidate);
+            acceptedMoves++;
+        }
+        trace.recordMove(temperature, p.totalWireLength);
+    }
+    return acceptedMoves;
+}
+
+// stepper that makes every move on the calling thread
+struct sequentialSteps {
+    template <class moveGenerator, class costModel, class recorder>
+    int run(placement &p, double temperature, int moves, double acceptanceRate, moveGenerator &generator,
+            costModel &cost, recorder &trace, annealRng &rng) {
+        return annealMovesWith(p, temperature, moves, generator, cost, trace, rng);
+    }
+};
+
+// stepper that hands the low-acceptance tail to a speculative annealer; only this stepper needs
+// the cost model's scratch-space evaluate() and commit()
+struct speculativeSteps {
+    speculativeAnnealer *speculation;
+
+    template <class moveGenerator, class costModel, class recorder>
+    int run(placement &p, double temperature, int moves, double acceptanceRate, moveGenerator &generator,
+            costModel &cost, recorder &trace, annealRng &rng) {
+        if (acceptanceRate < speculationAcceptanceRate) {
+            return speculation->annealMoves(p, temperature, moves, generator, cost, trace, rng);
+        }
+        return annealMovesWith(p, temperature, moves, generator, cost, trace, rng);
+    }
+};
+
+// anneals p from the initial to the final temperature of range, 10 moves per cell and step, and
+// returns the number of temperature steps taken
+template <class moveGenerator, class costModel, class schedulePolicy, class recorder, class stepper = sequentialSteps>
+int annealWith(placement &p, temperatureRange range, uint64_t seed, moveGenerator generator, costModel cost,
+               schedulePolicy schedule, recorder trace, stepper steps = stepper()) {
+    double temperature = range.initialTemperature;
+    int moves = 10*p.design->numOfCells;
+    annealRng rng(deriveSeed(seed, MOVE_STREAM));
+    generator.start(p);
+
+    int count = 0;
+    double acceptanceRate = 1;
+    while(temperature > range.finalTemperature) {
+        int acceptedMoves = steps.run(p, temperature, moves, acceptanceRate, generator, cost, trace, rng);
+        trace.endStep(temperature, acceptedMoves, p.totalWireLength);
+        acceptanceRate = (double)acceptedMoves / moves;
+        generator.endStep(p, acceptanceRate);
+        count++;
+        if (!schedule.cool(temperature, p.totalWireLength, acceptanceRate)) {
+            break;
+        }
+    }
+    return count;
+}
+
+// annealWith() on the default policies, the schedule and the recorder picked at run time.
+// Returns the number of temperature steps taken; with speculation the low-acceptance tail is
+// evaluated on its worker threads, with a trace every move and step is recorded
+int simulateAnnealingFast(placement &p, temperatureRange range, coolingSchedule schedule, uint64_t seed,
+                          speculativeAnnealer *speculation = nullptr, traceRecorder *trace = nullptr);
+
+// coolingRate is the geometric factor and is ignored by the adaptive schedule
+int simulateAnnealing(placement &p, temperatureRange range, double coolingRate, coolingSchedule schedule, uint64_t seed,
+                      speculativeAnnealer *speculation = nullptr, traceRecorder *trace = nullptr);
+
+// one anneal of the cooling-rate sweep
+struct sweepResult {
+    double coolingRate;
+    int run;
+    int finalWireLength;
+    std::string stepRows; // its rows of CoolingRate_Temp_TWL.csv
+};
+
+// anneals private copies of the same starting placement at every cooling rate, runs times each,
+// on a pool of threads. Run r uses the same seed at every rate, so the rates are compared on
+// common random numbers; results come back ordered by rate, then run.
+std::vector<sweepResult> runCoolingRateSweep(const placement &initial, const std::vector<double> &coolingRates, int runs, int threads, uint64_t seed);
+
+// domain-decomposed annealing of a single placement: every temperature step is one sweep in which
+// each thread makes moves confined to its own region of the grid. Boundary-crossing nets are
+// evaluated against a snapshot of the other regions and their bounding boxes are recomputed
+// between sweeps, which also resynchronizes the total wire length. Returns the number of steps.
+int simulateAnnealingRegions(placement &p, temperatureRange range, coolingSchedule schedule, int regions, uint64_t seed);
+
+// lock-free asynchronous annealing of a single placement for throughput runs, not reproducible
+// from a seed. All threads make moves on the shared placement at once. A thread claims both sites
+// of a move with a compare-and-swap before it reads their occupants, so a cell and the grid entries
+// it sits on only ever change under its claims. Net bounding boxes are not locked: a move is
+// evaluated and committed against boxes another thread may be updating, so they can go slightly
+// stale. That staleness is intended; cell positions, sites and boxes are shared through relaxed
+// atomic loads and stores, so it is never a data race. After every temperature step all boxes,
+// the total wire length and the free-site list are recomputed from the cell positions.
+// Returns the number of steps.
+int simulateAnnealingHogwild(placement &p, temperatureRange range, coolingSchedule schedule, int threads, uint64_t seed);
+
+// outcome of a replica exchange run
+struct temperingResult {
+    bool placed; // false when the replicas could not be placed, see placeInitiallyRandom()
+    int finalWireLength;
+    int attemptedExchanges;
+    int acceptedExchanges;
+};
+
+// parallel tempering: one placement per rung of a geometric temperature ladder between the
+// range's final (rung 0) and initial temperature, each annealed at its fixed temperature on its
+// own thread. After every epoch neighbouring rungs, alternating even and odd pairs, trade
+// placements with probability min(1, exp((1/Ti - 1/Tj)(Ei - Ej))). The best placement seen on
+// any rung is kept in best.
+temperingResult runParallelTempering(const netList &design, placement &best, int replicas, int epochs, temperatureRange range, uint64_t seed);
+
+// outcome of one independent placement of a multi-start run
+struct startResult {
+    int start;
+    uint64_t seed;
+    bool placed; // false when the cells could not be placed, nothing was annealed
+    int initialWireLength;
+    int finalWireLength;
+    int temperatureSteps;
+    double seconds;
+};
+
+// places and anneals one start from scratch on a private placement
+startResult runPlacement(const netList &design, placement &p, int start, uint64_t seed, coolingSchedule schedule, bool calibrate);
+
+// runs independent starts on a pool of threads sharing the read-only netlist and keeps the
+// placement with the lowest final wire length in best (ties go to the lower start index);
+// best is left untouched when no start could be placed
+std::vector<startResult> runMultiStart(const netList &design, int starts, int threads, coolingSchedule schedule, bool calibrate, uint64_t baseSeed, placement &best);
+
+#endif